@@ -0,0 +1,61 @@
+"""
+Fails the build when statically allocated RAM goes over budget
+
+All long-lived objects are statically allocated (see src/StaticObject.h), so .data + .bss + .noinit
+is everything the firmware uses apart from the stack. Whatever the budget leaves is the stack headroom.
+The budget is custom_ram_budget in platformio.ini, in bytes.
+
+Used as a PlatformIO post: script, checks the ELF after it links
+Can also be run by hand: python3 check_ram_budget.py <avr-size> <firmware.elf> <budget>
+"""
+
+import re
+import subprocess
+import sys
+
+RAM_SECTIONS = (".data", ".bss", ".noinit")
+
+
+def static_ram(size_tool, elf):
+    output = subprocess.check_output([size_tool, "-A", elf], universal_newlines=True)
+    total = 0
+
+    for line in output.splitlines():
+        match = re.match(r"^(\.\w+)\s+(\d+)\s+\d+", line)
+
+        if match and match.group(1) in RAM_SECTIONS:
+            total += int(match.group(2))
+
+    return total
+
+
+def check(size_tool, elf, budget):
+    used = static_ram(size_tool, elf)
+    print("Static RAM: %d of %d bytes budgeted, %d bytes spare" % (used, budget, budget - used))
+
+    if used > budget:
+        print("Error: static RAM is %d bytes over budget" % (used - budget))
+        return False
+
+    return True
+
+
+try:
+    Import("env")  # noqa: F821 - provided by PlatformIO
+except NameError:
+    env = None
+
+if env is not None:
+    def check_action(target, source, env):
+        budget = int(env.GetProjectOption("custom_ram_budget"))
+
+        if not check(env.subst("$SIZETOOL"), str(target[0]), budget):
+            env.Exit(1)
+
+    env.AddPostAction("$BUILD_DIR/${PROGNAME}.elf", check_action)
+elif __name__ == "__main__":
+    if len(sys.argv) != 4:
+        sys.exit("usage: %s <avr-size> <firmware.elf> <budget>" % sys.argv[0])
+
+    if not check(sys.argv[1], sys.argv[2], int(sys.argv[3])):
+        sys.exit(1)
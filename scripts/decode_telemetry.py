@@ -0,0 +1,158 @@
+"""
+Turns the debug serial output back into text, see src/Telemetry.h
+
+The firmware sends hot path events as binary records between ordinary console text:
+the event ID, then the arguments as laid out in src/TelemetryEvents.h, COBS encoded between two TELEMETRY_SYNC (0x00).
+Event IDs, layouts and texts are read from that header, so this never needs changing when events are added.
+Console text is passed through as it is, records are printed one per line.
+
+Console text never contains 0x00, so after lost bytes a record which does not decode is taken as text,
+and its closing 0x00 as the start of the next record, which brings the decoder back in step.
+
+Decode a capture: python3 decode_telemetry.py capture.bin (or - for stdin)
+Or watch the board: python3 decode_telemetry.py --port /dev/ttyUSB0, typed lines are sent to the debug console
+"""
+
+import argparse
+import os
+import re
+import struct
+import sys
+import threading
+
+EVENTS_HEADER = os.path.join(os.path.dirname(os.path.abspath(__file__)), os.pardir, "src", "TelemetryEvents.h")
+
+# must match src/Telemetry.h
+TELEMETRY_SYNC = 0x00
+
+
+def load_events(path):
+    events = []
+
+    with open(path) as header:
+        for match in re.finditer(r'X\((\w+),\s*"([^"]*)",\s*"([^"]*)"\)', header.read()):
+            name, layout, text = match.groups()
+            events.append((name, struct.Struct("<" + layout), text))
+
+    return events
+
+
+def cobs_decode(data):
+    """
+    Reverses the COBS encoding of a record, see frameRecord() in src/Telemetry.cpp
+    Returns the record, or None if data is not valid COBS
+    """
+    record = bytearray()
+    i = 0
+
+    while i < len(data):
+        code = data[i]
+
+        if code == 0 or i + code > len(data):
+            return None
+
+        record += data[i + 1:i + code]
+        i += code
+
+        if i < len(data):
+            record.append(TELEMETRY_SYNC)
+
+    return record
+
+
+def decode_record(data, events):
+    """
+    Returns the text of a framed record, or None if data is not one
+    """
+    record = cobs_decode(data)
+
+    if not record:
+        return None
+
+    if record[0] >= len(events):
+        return "<unknown telemetry event %d>" % record[0]
+
+    name, layout, text_format = events[record[0]]
+
+    if len(record) - 1 != layout.size:
+        return None
+
+    return text_format % layout.unpack(record[1:])
+
+
+def decode(stream, events, out):
+    text = bytearray()
+    in_record = False
+
+    def flush_text():
+        out.write(text.decode("ascii", errors="replace"))
+        text.clear()
+
+    while True:
+        byte = stream.read(1)
+
+        if not byte:
+            break
+
+        if byte[0] != TELEMETRY_SYNC:
+            text += byte
+
+            if byte == b"\n" and not in_record:
+                flush_text()
+
+            continue
+
+        if not in_record:
+            # the start of a record
+            flush_text()
+            in_record = True
+            continue
+
+        decoded = decode_record(text, events)
+
+        if decoded is None:
+            # out of step, what was taken for a record was text, and this starts the next record
+            flush_text()
+            continue
+
+        text.clear()
+        in_record = False
+        out.write(decoded + "\n")
+        out.flush()
+
+    if in_record and text:
+        out.write("<telemetry record cut short>\n")
+    else:
+        flush_text()
+
+
+def forward_input(port):
+    for line in sys.stdin:
+        port.write(line.encode("ascii", errors="ignore"))
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Decode the firmware's debug serial output")
+    parser.add_argument("capture", nargs="?", default="-", help="captured output, - for stdin")
+    parser.add_argument("--port", help="read from a serial port instead, needs pyserial")
+    parser.add_argument("--baud", type=int, default=115200, help="matches SER_BAUD in src/main.cpp")
+    parser.add_argument("--events", default=EVENTS_HEADER, help="path to TelemetryEvents.h")
+    args = parser.parse_args()
+
+    events = load_events(args.events)
+
+    if args.port:
+        import serial  # PlatformIO ships pyserial
+
+        port = serial.Serial(args.port, args.baud)
+        threading.Thread(target=forward_input, args=(port,), daemon=True).start()
+        decode(port, events, sys.stdout)
+    elif args.capture == "-":
+        decode(sys.stdin.buffer, events, sys.stdout)
+    else:
+        with open(args.capture, "rb") as capture:
+            decode(capture, events, sys.stdout)
+
+
+if __name__ == "__main__":
+    main()
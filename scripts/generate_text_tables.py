@@ -0,0 +1,336 @@
+"""
+Generates PROGMEM text layout tables for TextTables.cpp
+
+Every string the renderers draw is a number followed by a fixed suffix, and the numbers come from a small domain,
+so the pixel size of every possible string can be measured ahead of time from the Adafruit GFX font metrics.
+This writes TextTablesData.h with:
+ * a pool of number strings, shared by all tables
+ * a width/height table per kind of text, indexed by the displayed value
+ * each font cut down to the characters those strings use, repacked for GlyphBlitter
+ * the built-in 5x7 font, cut down to the characters of the compact temperature,
+   and in builds with the debug console also of the BusDiagnostics lines
+
+The string building rules here must match TextTables.cpp
+
+Used as a PlatformIO pre: script, the header is generated into the build directory before TextTables.cpp compiles
+Can also be run by hand: python3 generate_text_tables.py <directory containing Fonts/> <output header>
+"""
+
+import glob
+import os
+import re
+import sys
+
+HEADER_NAME = "TextTablesData.h"
+
+# screen width, strings are measured the same way Adafruit_GFX::getTextBounds() does for this width
+SCREEN_WIDTH = 128
+
+
+def temperature_text(unit):
+    # extra space is to make room for degree symbol, which isn't available in font
+    return lambda value: "%d  %s" % (value, unit)
+
+
+def distance_cm_text(value):
+    return "%dcm" % value
+
+
+def distance_in_text(value):
+    # only show feet if there is at least 1 foot
+    feet, inches = divmod(value, 12)
+    return "%dft %din" % (feet, inches) if feet > 0 else "%din" % inches
+
+
+# name, font, first value, last value, string builder
+TABLES = [
+    ("TEMPERATURE_C", "FreeSans18pt7b", -40, 88, temperature_text("C")),
+    ("TEMPERATURE_F", "FreeSans18pt7b", -40, 191, temperature_text("F")),
+    ("DISTANCE_CM", "FreeSans9pt7b", 0, 255, distance_cm_text),
+    ("DISTANCE_IN", "FreeSans9pt7b", 0, 100, distance_in_text),
+]
+
+# Adafruit GFX built-in font, each character 5 columns of 8 rows, drawn 6 columns apart
+BUILT_IN_FONT = "Glcdfont"
+BUILT_IN_WIDTH = 5
+BUILT_IN_ADVANCE = 6
+
+# every character of TextTables::getCompactTemperature()
+COMPACT_CHARS = " -0123456789CF"
+
+# every character the format strings in BusDiagnostics.cpp can produce, hex ARB IDs, counters and their labels
+# BusDiagnostics is only built with DO_DEBUG
+DIAGNOSTICS_CHARS = " -/0123456789ABCDEFOPRTdknoprsuv"
+
+GLYPH_PATTERN = re.compile(r"\{\s*(\d+)\s*,\s*(\d+)\s*,\s*(\d+)\s*,\s*(\d+)\s*,\s*(-?\d+)\s*,\s*(-?\d+)\s*\}")
+BYTE_PATTERN = re.compile(r"0x[0-9A-Fa-f]{1,2}")
+
+# SSD1306 page height, see src/OLED.h
+PAGE_HEIGHT = 8
+
+
+def parse_font(path, name):
+    """
+    Reads glyphs from an Adafruit GFX font header
+    Returns (first, glyphs, bitmap) where glyphs is a list of (width, height, xAdvance, xOffset, yOffset, bitmapOffset)
+    """
+    with open(path) as f:
+        source = f.read()
+
+    glyph_start = source.index(name + "Glyphs[]")
+    glyph_end = source.index("};", glyph_start)
+    glyphs = [
+        (int(m.group(2)), int(m.group(3)), int(m.group(4)), int(m.group(5)), int(m.group(6)), int(m.group(1)))
+        for m in GLYPH_PATTERN.finditer(source, glyph_start, glyph_end)
+    ]
+
+    bitmap_start = source.index("{", source.index(name + "Bitmaps[]"))
+    bitmap_end = source.index("};", bitmap_start)
+    bitmap = [int(m.group(0), 16) for m in BYTE_PATTERN.finditer(source, bitmap_start, bitmap_end)]
+
+    font = re.search(r"GFXfont\s+" + name + r"\s+PROGMEM\s*=\s*\{[^,]+,[^,]+,\s*(0x[0-9A-Fa-f]+|\d+)\s*,", source)
+    first = int(font.group(1), 0)
+
+    return first, glyphs, bitmap
+
+
+def parse_built_in_font(path):
+    """
+    Reads the built-in font from Adafruit GFX glcdfont.c
+    Returns the bitmap, BUILT_IN_WIDTH column bytes per character code, LSB at the top
+    """
+    with open(path) as f:
+        source = f.read()
+
+    bitmap_start = source.index("{", source.index("font[]"))
+    bitmap_end = source.index("};", bitmap_start)
+
+    return [int(m.group(0), 16) for m in BYTE_PATTERN.finditer(source, bitmap_start, bitmap_end)]
+
+
+def measure(font, text):
+    """
+    Measures text the same way Adafruit_GFX::getTextBounds() does with text size 1 at (0, 0)
+    Returns (width, height)
+    """
+    first, glyphs, _ = font
+    x = 0
+    min_x, min_y, max_x, max_y = SCREEN_WIDTH, 0x7FFF, -1, -1
+
+    for c in text:
+        index = ord(c) - first
+
+        if index < 0 or index >= len(glyphs):
+            raise ValueError("'%s' is not in font" % c)
+
+        gw, gh, xa, xo, yo, _ = glyphs[index]
+
+        if x + xo + gw > SCREEN_WIDTH:
+            raise ValueError("'%s' is too wide for the screen" % text)
+
+        x1 = x + xo
+        y1 = yo
+        min_x = min(min_x, x1)
+        min_y = min(min_y, y1)
+        max_x = max(max_x, x1 + gw - 1)
+        max_y = max(max_y, y1 + gh - 1)
+        x += xa
+
+    width = max_x - min_x + 1 if max_x >= min_x else 0
+    height = max_y - min_y + 1 if max_y >= min_y else 0
+
+    return width, height
+
+
+def find_fonts(search_dir):
+    """
+    Finds the Adafruit GFX font headers used by the tables
+    Returns a dict of font name to path
+    """
+    paths = {}
+
+    for name in {table[1] for table in TABLES}:
+        matches = glob.glob(os.path.join(search_dir, "**", "Fonts", name + ".h"), recursive=True)
+
+        if not matches:
+            raise FileNotFoundError("Could not find Fonts/%s.h in %s" % (name, search_dir))
+
+        paths[name] = matches[0]
+
+    matches = glob.glob(os.path.join(search_dir, "**", "glcdfont.c"), recursive=True)
+
+    if not matches:
+        raise FileNotFoundError("Could not find glcdfont.c in %s" % search_dir)
+
+    paths[BUILT_IN_FONT] = matches[0]
+
+    return paths
+
+
+def repack_glyph(font, c):
+    """
+    Converts a glyph from Adafruit GFX rows of bits, MSB first and not padded between rows,
+    to SSD1306 page-major column bytes, LSB at the top, with the glyph's top row as bit 0 of its first page
+    Returns (columns, pages, xAdvance, xOffset, yOffset, bytes)
+    """
+    first, glyphs, bitmap = font
+    gw, gh, xa, xo, yo, offset = glyphs[ord(c) - first]
+    pages = (gh + PAGE_HEIGHT - 1) // PAGE_HEIGHT
+    packed = [0] * (gw * pages)
+
+    for y in range(gh):
+        for x in range(gw):
+            bit = y * gw + x
+
+            if bitmap[offset + bit // 8] & (0x80 >> (bit % 8)):
+                packed[(y // PAGE_HEIGHT) * gw + x] |= 1 << (y % PAGE_HEIGHT)
+
+    return gw, pages, xa, xo, yo, packed
+
+
+def built_in_glyph(bitmap, c):
+    """
+    A glyph of the built-in font, already one page of column bytes
+    Adafruit_GFX::setCursor() gives its top row rather than a baseline, so the top is at offset 0
+    Returns (columns, pages, xAdvance, xOffset, yOffset, bytes)
+    """
+    offset = ord(c) * BUILT_IN_WIDTH
+
+    return BUILT_IN_WIDTH, 1, BUILT_IN_ADVANCE, 0, 0, bitmap[offset:offset + BUILT_IN_WIDTH]
+
+
+def font_lines(font_name, glyph, chars):
+    """
+    C declarations of a font cut down to chars, see PageFont in src/GlyphBlitter.h
+    glyph returns repack_glyph() results for a character
+    """
+    symbol = "pageFont" + font_name
+    bitmap = []
+    glyph_lines = []
+
+    for c in chars:
+        columns, pages, xa, xo, yo, packed = glyph(c)
+        glyph_lines.append("    {%d, %d, %d, %d, %d, %d}, // '%s'" % (len(bitmap), columns, pages, xa, xo, yo, c))
+        bitmap += packed
+
+    lines = [
+        "// %s cut down to the characters drawn, %d glyph bytes" % (font_name, len(bitmap)),
+        "static const char %sChars[] PROGMEM = \"%s\";" % (symbol, chars),
+        "static const uint8_t %sBitmap[] PROGMEM = {" % symbol,
+    ]
+
+    lines += ["    " + ", ".join("0x%02X" % b for b in bitmap[i:i + 16]) + "," for i in range(0, len(bitmap), 16)]
+    lines += ["};", "static const PageGlyph %sGlyphs[] PROGMEM = {" % symbol]
+    lines += glyph_lines
+    lines += [
+        "};",
+        "static const PageFont %s PROGMEM = {%sChars, %sGlyphs, %sBitmap};" % (symbol, symbol, symbol, symbol),
+        "",
+    ]
+
+    return lines
+
+
+def number_pool_range():
+    """
+    Every number used by any table must be in the pool
+    Distance in inches also uses feet, which are always smaller than the inches
+    """
+    return min(t[2] for t in TABLES), max(t[3] for t in TABLES)
+
+
+def generate(search_dir, output):
+    paths = find_fonts(search_dir)
+    built_in = parse_built_in_font(paths.pop(BUILT_IN_FONT))
+    fonts = {name: parse_font(path, name) for name, path in paths.items()}
+    pool_min, pool_max = number_pool_range()
+    pool_size = max(len(str(v)) for v in range(pool_min, pool_max + 1)) + 1
+    max_text = 0
+
+    lines = [
+        "// Generated by scripts/generate_text_tables.py from Adafruit GFX font metrics, do not edit",
+        "#ifndef TEXT_TABLES_DATA_H",
+        "#define TEXT_TABLES_DATA_H",
+        "",
+        "#define TEXT_TABLE_NUMBER_MIN (%d)" % pool_min,
+        "#define TEXT_TABLE_NUMBER_MAX %d" % pool_max,
+        "#define TEXT_TABLE_NUMBER_SIZE %d" % pool_size,
+        "",
+        "static const char textTableNumbers[][TEXT_TABLE_NUMBER_SIZE] PROGMEM = {",
+    ]
+
+    lines += ['    "%d",' % v for v in range(pool_min, pool_max + 1)]
+    lines += ["};", ""]
+
+    # only characters which some string uses are kept
+    font_chars = {}
+
+    for _, font_name, first, last, text in TABLES:
+        font_chars.setdefault(font_name, set()).update("".join(text(value) for value in range(first, last + 1)))
+
+    for font_name in sorted(font_chars):
+        font = fonts[font_name]
+        lines += font_lines(font_name, lambda c: repack_glyph(font, c), "".join(sorted(font_chars[font_name])))
+
+    # the header is compiled with the build's flags, so it picks the cut down font the build needs
+    debug_chars = "".join(sorted(set(COMPACT_CHARS + DIAGNOSTICS_CHARS)))
+    lines += ["#if DO_DEBUG == 1"]
+    lines += font_lines(BUILT_IN_FONT, lambda c: built_in_glyph(built_in, c), debug_chars)
+    lines += ["#else"]
+    lines += font_lines(BUILT_IN_FONT, lambda c: built_in_glyph(built_in, c), COMPACT_CHARS)
+    lines += [
+        "#endif",
+        "#define TEXT_BUILT_IN_FONT pageFont%s" % BUILT_IN_FONT,
+        "#define TEXT_TABLE_BUILT_IN_ADVANCE %d" % BUILT_IN_ADVANCE,
+        "",
+    ]
+
+    for name, font_name, first, last, text in TABLES:
+        lines += [
+            "// %s, %s" % (text(first), font_name),
+            "#define TEXT_TABLE_%s_MIN (%d)" % (name, first),
+            "#define TEXT_TABLE_%s_MAX %d" % (name, last),
+            "#define TEXT_TABLE_%s_FONT pageFont%s" % (name, font_name),
+            "static const uint8_t textTable%s[][2] PROGMEM = {" % name.title().replace("_", ""),
+        ]
+
+        for value in range(first, last + 1):
+            width, height = measure(fonts[font_name], text(value))
+            max_text = max(max_text, len(text(value)))
+            lines.append("    {%d, %d}, // \"%s\"" % (width, height, text(value)))
+
+        lines += ["};", ""]
+
+    lines += [
+        "// longest string, not including NUL",
+        "#define TEXT_TABLE_LONGEST %d" % max_text,
+        "",
+        "#endif //TEXT_TABLES_DATA_H",
+        "",
+    ]
+
+    os.makedirs(os.path.dirname(output), exist_ok=True)
+
+    with open(output, "w") as f:
+        f.write("\n".join(lines))
+
+
+try:
+    Import("env")  # noqa: F821 - provided by PlatformIO
+except NameError:
+    env = None
+
+if env is not None:
+    generated_dir = os.path.join(env.subst("$BUILD_DIR"), "generated")
+    env.Append(CPPPATH=[generated_dir])
+
+    def generate_action(*args, **kwargs):
+        # libraries are installed after pre: scripts run, so fonts can only be found once building starts
+        generate(env.subst("$PROJECT_LIBDEPS_DIR/$PIOENV"), os.path.join(generated_dir, HEADER_NAME))
+
+    env.AddPreAction("$BUILD_DIR/src/TextTables.cpp.o", generate_action)
+elif __name__ == "__main__":
+    if len(sys.argv) != 3:
+        sys.exit("usage: %s <directory containing Fonts/> <output header>" % sys.argv[0])
+
+    generate(sys.argv[1], sys.argv[2])
@@ -0,0 +1,308 @@
+#ifndef ARB_REGISTRY_H
+#define ARB_REGISTRY_H
+
+#include <Arduino.h>
+#include "GMLan.h"
+
+// the MCP25625 has 2 masks, mask 0 applies to filters 0-1 (RXB0) and mask 1 applies to filters 2-5 (RXB1)
+#define ARB_REGISTRY_MASKS 2
+#define ARB_REGISTRY_FILTERS 6
+#define ARB_REGISTRY_RXB0_FILTERS 2
+
+// mask used for exact matching of a GMLAN ARB ID
+#define ARB_REGISTRY_ARB_MASK 0x00FFE000UL
+
+// largest dispatch table searched for a perfect hash, must fit the 8-bit shift/size search below
+#define ARB_REGISTRY_MAX_TABLE 32
+
+// ARB ID which can't be received, used for empty dispatch table slots
+#define ARB_REGISTRY_NO_ID 0xFFFFFFFFUL
+
+// returned by ArbRegistry::indexOf() for ARB IDs which are not in the registry
+#define ARB_REGISTRY_NO_INDEX 0xFF
+
+// CANBUS mask or filter data
+struct CanMaskFilterData {
+    uint8_t ext = 0;
+    uint32_t ulData = 0x00000000;
+};
+
+/**
+ * Which consumers handle an ARB ID
+ * consumers is a bitmask, bit N set means the Nth type given to ArbRegistry handles the ARB ID
+ * index is the ARB ID's position in the registry, from 0 to ArbRegistry::numArbIds - 1
+ */
+struct ArbRoute {
+    uint32_t arbId = ARB_REGISTRY_NO_ID;
+    uint8_t consumers = 0;
+    uint8_t index = ARB_REGISTRY_NO_INDEX;
+};
+
+/**
+ * Every ARB ID in the registry, in the order consumers declared them
+ */
+struct ArbRouteList {
+    ArbRoute routes[ARB_REGISTRY_FILTERS];
+    uint8_t count = 0;
+};
+
+/**
+ * Perfect hash parameters, hash(id) = (id ^ (id >> shift)) & (size - 1)
+ */
+struct ArbHash {
+    uint8_t shift = 0;
+    uint8_t size = 0;
+};
+
+/**
+ * ARB IDs a consumer declared with static constexpr uint32_t ARB_IDS[]
+ * @tparam Consumer the consumer type
+ */
+template<typename Consumer, typename = void>
+struct ArbIdsOf {
+    static constexpr const uint32_t* ids = nullptr;
+    static constexpr size_t count = 0;
+};
+
+/**
+ * Consumers which declare ARB_IDS, the others handle no ARB IDs
+ * @tparam Consumer the consumer type
+ */
+template<typename Consumer>
+struct ArbIdsOf<Consumer, decltype(void(Consumer::ARB_IDS))> {
+    static constexpr const uint32_t* ids = Consumer::ARB_IDS;
+    static constexpr size_t count = sizeof(Consumer::ARB_IDS) / sizeof(uint32_t);
+};
+
+/**
+ * Compile-time helpers for ArbRegistry
+ * These live outside of the template so they are complete when ArbRegistry's constants are evaluated
+ */
+class ArbRegistryBuilder {
+public:
+    /**
+     * Add one consumer's ARB IDs to a route list, merging IDs which another consumer already declared
+     * Running out of filters leaves count past the end, which ArbRegistry rejects with a static_assert
+     * @param list the list to add to
+     * @param ids the consumer's ARB IDs
+     * @param numIds number of ARB IDs
+     * @param consumer index of the consumer
+     */
+    static constexpr void add(ArbRouteList& list, const uint32_t* ids, const size_t numIds, const uint8_t consumer) {
+        for (size_t i = 0; i < numIds; i++) {
+            bool found = false;
+
+            for (uint8_t j = 0; j < list.count && j < ARB_REGISTRY_FILTERS; j++) {
+                if (list.routes[j].arbId == ids[i]) {
+                    list.routes[j].consumers |= static_cast<uint8_t>(1U << consumer);
+                    found = true;
+                }
+            }
+
+            if (!found) {
+                if (list.count < ARB_REGISTRY_FILTERS) {
+                    list.routes[list.count].arbId = ids[i];
+                    list.routes[list.count].consumers = static_cast<uint8_t>(1U << consumer);
+                }
+
+                list.count++;
+            }
+        }
+    }
+
+    /**
+     * Hash an ARB ID into a dispatch table slot
+     * @param arbId the ARB ID
+     * @param hash the hash parameters
+     * @return the slot
+     */
+    static constexpr uint8_t slot(const uint32_t arbId, const ArbHash hash) {
+        return static_cast<uint8_t>((arbId ^ (arbId >> hash.shift)) & (hash.size - 1U));
+    }
+
+    /**
+     * Find the smallest power-of-two table and shift which give every ARB ID its own slot
+     * @param list the ARB IDs
+     * @return the hash parameters, size is 0 if none was found
+     */
+    static constexpr ArbHash findHash(const ArbRouteList& list) {
+        for (uint8_t size = 1; size <= ARB_REGISTRY_MAX_TABLE; size = static_cast<uint8_t>(size * 2)) {
+            if (size < list.count) {
+                continue;
+            }
+
+            // GMLAN ARB IDs are 13 bits, so a shift of 13 is the ARB ID itself
+            for (uint8_t shift = 13; shift > 0; shift--) {
+                const ArbHash hash = {shift, size};
+                bool collision = false;
+
+                for (uint8_t i = 0; i < list.count && !collision; i++) {
+                    for (uint8_t j = i + 1; j < list.count && !collision; j++) {
+                        collision = slot(list.routes[i].arbId, hash) == slot(list.routes[j].arbId, hash);
+                    }
+                }
+
+                if (!collision) {
+                    return hash;
+                }
+            }
+        }
+
+        return {};
+    }
+};
+
+/**
+ * Compile-time registry of the GMLAN ARB IDs the firmware consumes
+ * Each consumer type declares static constexpr uint32_t ARB_IDS[] with the ARB IDs it handles,
+ * a consumer without ARB_IDS keeps its bit but never receives anything
+ * From those, this generates the MCP25625 masks and filters, and an O(1) ARB ID to consumer lookup,
+ * so the hardware filters can never disagree with what the software handles
+ * @tparam Consumers the consumer types, a consumer's bit in consumersOf() is its position in this list
+ */
+template<typename... Consumers>
+class ArbRegistry {
+public:
+    /**
+     * Number of consumer types
+     */
+    static constexpr uint8_t numConsumers = sizeof...(Consumers);
+
+private:
+    static_assert(numConsumers <= 8, "ArbRegistry consumer bitmask only fits 8 consumers");
+
+    /**
+     * Every ARB ID, merged across consumers
+     */
+    static constexpr ArbRouteList list = [] {
+        ArbRouteList result{};
+        uint8_t consumer = 0;
+        (ArbRegistryBuilder::add(result, ArbIdsOf<Consumers>::ids, ArbIdsOf<Consumers>::count, consumer++), ...);
+        return result;
+    }();
+
+    static_assert(list.count > 0, "ArbRegistry needs at least one ARB ID");
+    static_assert(list.count <= ARB_REGISTRY_FILTERS, "ArbRegistry has more ARB IDs than the MCP25625 has filters");
+
+    /**
+     * Perfect hash over every ARB ID
+     */
+    static constexpr ArbHash hash = ArbRegistryBuilder::findHash(list);
+
+    static_assert(hash.size > 0, "ArbRegistry could not find a perfect hash for these ARB IDs");
+
+    /**
+     * Dispatch table, indexed by the perfect hash, in PROGMEM
+     */
+    struct Table {
+        ArbRoute slots[hash.size];
+    };
+
+    static constexpr Table table PROGMEM = [] {
+        Table result{};
+
+        for (uint8_t i = 0; i < list.count; i++) {
+            ArbRoute& route = result.slots[ArbRegistryBuilder::slot(list.routes[i].arbId, hash)];
+            route = list.routes[i];
+            route.index = i;
+        }
+
+        return result;
+    }();
+
+public:
+    /**
+     * Number of ARB IDs in the registry
+     */
+    static constexpr uint8_t numArbIds = list.count;
+
+    /**
+     * Determine at compile time whether an ARB ID is in the registry
+     * @param arbId the ARB ID
+     * @return whether some consumer handles it
+     */
+    static constexpr bool contains(const uint32_t arbId) {
+        for (uint8_t i = 0; i < list.count; i++) {
+            if (list.routes[i].arbId == arbId) {
+                return true;
+            }
+        }
+
+        return false;
+    }
+
+    /**
+     * Look up which consumers handle an ARB ID
+     * @param arbId the ARB ID, already extracted from the CAN ID with GMLAN_ARB()
+     * @return bitmask of consumers, 0 if nothing handles this ARB ID
+     */
+    static uint8_t consumersOf(const uint32_t arbId) {
+        const ArbRoute& route = table.slots[ArbRegistryBuilder::slot(arbId, hash)];
+        return pgm_read_dword(&route.arbId) == arbId ? pgm_read_byte(&route.consumers) : 0;
+    }
+
+    /**
+     * Look up an ARB ID's position in the registry, for per-ARB ID storage
+     * @param arbId the ARB ID, already extracted from the CAN ID with GMLAN_ARB()
+     * @return index from 0 to numArbIds - 1, ARB_REGISTRY_NO_INDEX if the ARB ID is not in the registry
+     */
+    static uint8_t indexOf(const uint32_t arbId) {
+        const ArbRoute& route = table.slots[ArbRegistryBuilder::slot(arbId, hash)];
+        return pgm_read_dword(&route.arbId) == arbId ? pgm_read_byte(&route.index) : ARB_REGISTRY_NO_INDEX;
+    }
+
+    /**
+     * Look up the ARB ID at a position in the registry, the reverse of indexOf()
+     * @param index from 0 to numArbIds - 1
+     * @return the ARB ID, ARB_REGISTRY_NO_ID if index is out of range
+     */
+    static uint32_t arbIdOf(const uint8_t index) {
+        for (const ArbRoute& route : table.slots) {
+            if (pgm_read_byte(&route.index) == index) {
+                return pgm_read_dword(&route.arbId);
+            }
+        }
+
+        return ARB_REGISTRY_NO_ID;
+    }
+
+    /**
+     * Hardware mask, every mask matches ARB IDs exactly
+     * @param maskId the mask number
+     * @return the mask data
+     */
+    static constexpr CanMaskFilterData mask([[maybe_unused]] const uint8_t maskId) {
+        return {1, ARB_REGISTRY_ARB_MASK};
+    }
+
+    /**
+     * Hardware filter, one per ARB ID
+     * Filters beyond the number of ARB IDs repeat the last ARB ID, so they never let anything else through
+     * @param filterId the filter number
+     * @return the filter data
+     */
+    static constexpr CanMaskFilterData filter(const uint8_t filterId) {
+        const uint8_t index = filterId < list.count ? filterId : list.count - 1;
+        return {1, GMLAN_R_ARB(list.routes[index].arbId)};
+    }
+
+    /**
+     * First filter number using a mask
+     * @param maskId the mask number
+     * @return the first filter
+     */
+    static constexpr uint8_t firstFilter(const uint8_t maskId) {
+        return maskId == 0 ? 0 : ARB_REGISTRY_RXB0_FILTERS;
+    }
+
+    /**
+     * One past the last filter number using a mask
+     * @param maskId the mask number
+     * @return the end filter
+     */
+    static constexpr uint8_t endFilter(const uint8_t maskId) {
+        return maskId == 0 ? ARB_REGISTRY_RXB0_FILTERS : ARB_REGISTRY_FILTERS;
+    }
+};
+
+#endif //ARB_REGISTRY_H
@@ -0,0 +1,177 @@
+#include <Arduino.h>
+
+#include "BusDiagnostics.h"
+#include "BusMonitor.h"
+#include "CanReceiver.h"
+#include "Pipeline.h"
+#include "TextTables.h"
+#include "OLED.h"
+
+// only built with the debug console, which turns the page on, see GMLanRenderers
+#if DO_DEBUG == 1
+// the built-in font is 8 pixels high including spacing, so the display has one line per page
+// every character of these lines must be in DIAGNOSTICS_CHARS in scripts/generate_text_tables.py
+#define BUS_DIAGNOSTICS_LINE_H 8
+
+bool BusDiagnostics::enabled = false;
+
+/**
+ * Determine whether a line is built, only lines wholly inside the region and on the canvas are
+ * @param canvas the page being built
+ * @param region the region of the renderer
+ * @param y top row of the line
+ * @return whether to build it
+ */
+static bool isLineDrawn(const PageCanvas& canvas, const Region& region, int16_t const y) {
+    return y + BUS_DIAGNOSTICS_LINE_H <= region.y + region.h && canvas.overlaps(y, BUS_DIAGNOSTICS_LINE_H);
+}
+
+/**
+ * Create a BusDiagnostics instance
+ * @param flusher partial display updater
+ * @param units the initial unit state
+ */
+BusDiagnostics::BusDiagnostics(PageFlusher* flusher, uint8_t const units) : Renderer(flusher, units) {}
+
+/**
+ * Turn the page on or off
+ * @param enable whether to show it
+ */
+void BusDiagnostics::setEnabled(bool const enable) {
+    enabled = enable;
+}
+
+/**
+ * Determine whether the page is shown
+ * @return whether it is on
+ */
+bool BusDiagnostics::isEnabled() {
+    return enabled;
+}
+
+/**
+ * Process GMLAN message, never called as no ARB IDs are registered
+ * @param arbId the arbitration ID
+ * @param len the length of the buffer data
+ * @param buf buffer data from GMLAN
+ */
+void BusDiagnostics::processMessage(
+    [[maybe_unused]] uint32_t const arbId,
+    [[maybe_unused]] uint8_t const len,
+    [[maybe_unused]] uint8_t buf[8]
+) {}
+
+/**
+ * Shows the statistics of the last BusMonitor window
+ * Marks the whole region dirty
+ */
+void BusDiagnostics::render() {
+    markRegionDirty();
+    renderedWindow = BusMonitor::getWindow();
+    needsRender = false;
+}
+
+/**
+ * Draws frame rates per ARB ID, two to a line, then the controller's counters
+ * Only the lines on the canvas are built, lines which don't fit the region are left out
+ * @param canvas the page being built
+ */
+void BusDiagnostics::draw(PageCanvas& canvas) const {
+    const BusStats& stats = BusMonitor::getStats();
+    const PageFont* font = TextTables::getBuiltInFont();
+    char line[BUS_DIAGNOSTICS_LINE_LEN];
+    int16_t y = region.y;
+
+    for (uint8_t i = 0; i < GMLanRegistry::numArbIds; i += 2, y += BUS_DIAGNOSTICS_LINE_H) {
+        if (!isLineDrawn(canvas, region, y)) {
+            continue;
+        }
+
+        int length = snprintf_P(
+            line,
+            sizeof(line),
+            PSTR("%03lX %3u/s"),
+            static_cast<unsigned long>(GMLanRegistry::arbIdOf(i)),
+            stats.framesPerSecond[i]
+        );
+
+        if (i + 1 < GMLanRegistry::numArbIds) {
+            snprintf_P(
+                line + length,
+                sizeof(line) - length,
+                PSTR("  %03lX %3u/s"),
+                static_cast<unsigned long>(GMLanRegistry::arbIdOf(i + 1)),
+                stats.framesPerSecond[i + 1]
+            );
+        }
+
+        canvas.drawText(font, region.x, y, line);
+    }
+
+    if (isLineDrawn(canvas, region, y)) {
+        snprintf_P(
+            line,
+            sizeof(line),
+            PSTR("unk %u ovr %u drop %u"),
+            stats.unrecognized,
+            CanReceiver::getControllerOverflows(),
+            CanReceiver::getDroppedFrames()
+        );
+        canvas.drawText(font, region.x, y, line);
+    }
+
+    y += BUS_DIAGNOSTICS_LINE_H;
+
+    if (isLineDrawn(canvas, region, y)) {
+        snprintf_P(
+            line,
+            sizeof(line),
+            PSTR("REC %u TEC %u EP %u BO %u"),
+            stats.errors.rxErrors,
+            stats.errors.txErrors,
+            stats.errorPassive,
+            stats.busOff
+        );
+        canvas.drawText(font, region.x, y, line);
+    }
+}
+
+/**
+ * Determines whether there is new data to render
+ * Rendering should happen whenever the page is on, so lower priority renderers never draw over it
+ * It is only drawn again once BusMonitor closed a window
+ * @return whether rendering should occur
+ */
+bool BusDiagnostics::shouldRender() {
+    if (renderedWindow != BusMonitor::getWindow()) {
+        needsRender = true;
+    }
+
+    return enabled;
+}
+
+/**
+ * Determines whether there is data which can be rendered
+ * Rendering may happen if the page is on
+ * @return whether rendering can occur
+ */
+bool BusDiagnostics::canRender() {
+    return enabled;
+}
+
+/**
+ * Determines when the statistics will next change
+ * @return Clock::now() timestamp of the end of the BusMonitor window
+ */
+uint32_t BusDiagnostics::getNextDeadline() {
+    return BusMonitor::getWindowEnd();
+}
+
+/**
+ * Returns the name of this renderer
+ * @return the name as a string
+ */
+const __FlashStringHelper* BusDiagnostics::getName() const {
+    return F("BusDiagnostics");
+}
+#endif
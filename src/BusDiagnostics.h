@@ -0,0 +1,96 @@
+#ifndef BUS_DIAGNOSTICS_H
+#define BUS_DIAGNOSTICS_H
+
+#include <Arduino.h>
+#include "Renderer.h"
+
+// longest line built for the diagnostics page, including NUL - example "REC 255 TEC 255 EP 65535 BO 65535"
+// the built-in font fits 21 characters across, anything further is clipped, in practice the counters stay short
+#define BUS_DIAGNOSTICS_LINE_LEN 36
+
+/**
+ * Optional diagnostics page, showing BusMonitor statistics instead of the temperature
+ * Turned on from the debug console, park assist still takes over the display
+ * Lines are as wide as the display, so its layouts give it the whole width
+ * Processes no GMLAN data, so it declares no ARB_IDS
+ */
+class BusDiagnostics final : public Renderer {
+    /**
+     * Whether the page is shown, there is only ever one page
+     */
+    static bool enabled;
+
+    /**
+     * BusMonitor::getWindow() of the statistics on the display
+     */
+    uint8_t renderedWindow = 0;
+
+public:
+    /**
+     * Create a BusDiagnostics instance
+     * @param flusher partial display updater
+     * @param units the initial unit state
+     */
+    BusDiagnostics(PageFlusher *flusher, uint8_t units);
+
+    /**
+     * Turn the page on or off
+     * @param enable whether to show it
+     */
+    static void setEnabled(bool enable);
+
+    /**
+     * Determine whether the page is shown
+     * @return whether it is on
+     */
+    [[nodiscard]] static bool isEnabled();
+
+    /**
+     * Process GMLAN message, never called as no ARB IDs are registered
+     * @param arbId the arbitration ID
+     * @param len the length of the buffer data
+     * @param buf buffer data from GMLAN
+     */
+    void processMessage(uint32_t arbId, uint8_t len, uint8_t buf[8]);
+
+    /**
+     * Shows the statistics of the last BusMonitor window
+     * Marks the whole region dirty
+     */
+    void render();
+
+    /**
+     * Draws frame rates per ARB ID, then the controller's counters
+     * @param canvas the page being built
+     */
+    void draw(PageCanvas& canvas) const;
+
+    /**
+     * Determines whether there is new data to render
+     * Rendering should happen whenever the page is on, so lower priority renderers never draw over it
+     * It is only drawn again once BusMonitor closed a window
+     * @return whether rendering should occur
+     */
+    bool shouldRender();
+
+    /**
+     * Determines whether there is data which can be rendered
+     * Rendering may happen if the page is on
+     * @return whether rendering can occur
+     */
+    bool canRender();
+
+    /**
+     * Determines when the statistics will next change
+     * @return Clock::now() timestamp of the end of the BusMonitor window
+     */
+    uint32_t getNextDeadline();
+
+    /**
+     * Returns the name of this renderer
+     * @return the name as a string
+     */
+    [[nodiscard]] const __FlashStringHelper* getName() const;
+};
+
+#endif //BUS_DIAGNOSTICS_H
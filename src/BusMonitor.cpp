@@ -0,0 +1,92 @@
+#include "BusMonitor.h"
+#include "Clock.h"
+#include "Deadline.h"
+
+static BusStats stats = {};
+static uint16_t windowFrames[BUS_MONITOR_ARB_IDS] = {};
+static uint32_t windowStart = 0;
+static uint8_t window = 0;
+
+/**
+ * Count a frame taken from the receive ring
+ * @param index the frame's ArbRegistry::indexOf(), ARB_REGISTRY_NO_INDEX if no consumer handles it
+ */
+void BusMonitor::countFrame(uint8_t const index) {
+    if (index < BUS_MONITOR_ARB_IDS) {
+        windowFrames[index]++;
+    } else {
+        stats.unrecognized++;
+    }
+}
+
+/**
+ * Close the window once it is over, computing frame rates and reading the controller
+ * The main loop sleeps, so a window may run long, rates are computed over its real length
+ * The controller can't be read while the OLED has the SPI bus, then it is read on a later call
+ * Call from the main loop
+ */
+void BusMonitor::update() {
+    const uint32_t now = Clock::now();
+    const uint32_t elapsed = now - windowStart;
+
+    if (elapsed < BUS_MONITOR_WINDOW_MS) {
+        return;
+    }
+
+    const uint8_t before = stats.errors.flags;
+
+    if (!CanReceiver::readErrorState(stats.errors)) {
+        return;
+    }
+
+    const uint8_t entered = stats.errors.flags & ~before;
+
+    if (entered & (MCP_EFLG_RXEP | MCP_EFLG_TXEP)) {
+        stats.errorPassive++;
+    }
+
+    if (entered & MCP_EFLG_TXBO) {
+        stats.busOff++;
+    }
+
+    for (uint8_t i = 0; i < BUS_MONITOR_ARB_IDS; i++) {
+        stats.framesPerSecond[i] = static_cast<uint16_t>((windowFrames[i] * 1000UL + elapsed / 2) / elapsed);
+        windowFrames[i] = 0;
+    }
+
+    windowStart = now;
+    window++;
+}
+
+/**
+ * Statistics as of the last closed window
+ * @return the statistics
+ */
+const BusStats& BusMonitor::getStats() {
+    return stats;
+}
+
+/**
+ * Number of windows closed so far, wrapping, to tell when the statistics changed
+ * @return the window number
+ */
+uint8_t BusMonitor::getWindow() {
+    return window;
+}
+
+/**
+ * Determine when the current window will be closed
+ * @return Clock::now() timestamp
+ */
+uint32_t BusMonitor::getWindowEnd() {
+    return makeDeadline(windowStart + BUS_MONITOR_WINDOW_MS);
+}
+
+/**
+ * Reset the unrecognized frame and error transition counters
+ */
+void BusMonitor::clearCounters() {
+    stats.unrecognized = 0;
+    stats.errorPassive = 0;
+    stats.busOff = 0;
+}
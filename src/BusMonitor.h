@@ -0,0 +1,87 @@
+#ifndef BUS_MONITOR_H
+#define BUS_MONITOR_H
+
+#include <Arduino.h>
+#include "ArbRegistry.h"
+#include "CanReceiver.h"
+
+// frame rates are counted over windows of this length
+#define BUS_MONITOR_WINDOW_MS 1000UL
+
+// one frame rate per ARB ID in the registry, indexed by ArbRegistry::indexOf()
+#define BUS_MONITOR_ARB_IDS ARB_REGISTRY_FILTERS
+
+/**
+ * What the CAN controller saw, see BusMonitor
+ */
+struct BusStats {
+    /**
+     * Frames per second of each registered ARB ID over the last window, indexed by ArbRegistry::indexOf()
+     */
+    uint16_t framesPerSecond[BUS_MONITOR_ARB_IDS];
+
+    /**
+     * Frames which passed the controller filters but which no consumer handles, since the last clearCounters()
+     */
+    uint16_t unrecognized;
+
+    /**
+     * Times the controller went error-passive, since the last clearCounters()
+     */
+    uint16_t errorPassive;
+
+    /**
+     * Times the controller went bus-off, since the last clearCounters()
+     */
+    uint16_t busOff;
+
+    /**
+     * Controller error state, as last read
+     */
+    CanErrorState errors;
+};
+
+/**
+ * GMLAN bus load and CAN controller health, for tuning filters and finding out why data went missing
+ * Frames are counted as the main loop takes them, the controller is read once per window
+ * RX overflows are counted by CanReceiver
+ */
+class BusMonitor {
+public:
+    /**
+     * Count a frame taken from the receive ring
+     * @param index the frame's ArbRegistry::indexOf(), ARB_REGISTRY_NO_INDEX if no consumer handles it
+     */
+    static void countFrame(uint8_t index);
+
+    /**
+     * Close the window once it is over, computing frame rates and reading the controller
+     * Call from the main loop
+     */
+    static void update();
+
+    /**
+     * Statistics as of the last closed window
+     * @return the statistics
+     */
+    [[nodiscard]] static const BusStats& getStats();
+
+    /**
+     * Number of windows closed so far, wrapping, to tell when the statistics changed
+     * @return the window number
+     */
+    [[nodiscard]] static uint8_t getWindow();
+
+    /**
+     * Determine when the current window will be closed
+     * @return Clock::now() timestamp
+     */
+    [[nodiscard]] static uint32_t getWindowEnd();
+
+    /**
+     * Reset the unrecognized frame and error transition counters
+     */
+    static void clearCounters();
+};
+
+#endif //BUS_MONITOR_H
@@ -0,0 +1,246 @@
+#include <SPI.h>
+#include <util/atomic.h>
+
+#include "CanReceiver.h"
+
+// SPI clock used by the mcp_can library
+static constexpr uint32_t MCP_SPI_BAUD = 10000000UL;
+
+static MCP_CAN* canBus = nullptr;
+static uint8_t canCsPin = 0;
+static uint8_t canIntPin = 0;
+
+static RingBuffer<CanFrame, CAN_RX_RING_SIZE> ring;
+static volatile uint16_t droppedFrames = 0;
+static volatile uint16_t controllerOverflows = 0;
+static volatile bool held = false;
+
+/**
+ * CAN_INT changed
+ * Pin-change interrupts fire on both edges, drain() does nothing if the pin went high
+ */
+ISR(PCINT1_vect) {
+    CanReceiver::drain();
+}
+
+/**
+ * Start interrupt-driven reception
+ * Controller must already be initialized
+ * @param bus the CAN controller
+ * @param csPin the CAN controller chip select pin
+ * @param intPin the CAN controller interrupt pin, must be on port C (PCINT8-14)
+ */
+void CanReceiver::begin(MCP_CAN* bus, uint8_t const csPin, uint8_t const intPin) {
+    canBus = bus;
+    canCsPin = csPin;
+    canIntPin = intPin;
+
+    // SPI is shared with the OLED, its transactions hold off only this interrupt, see SpiBus
+
+    pinMode(intPin, INPUT);
+
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+        *digitalPinToPCMSK(intPin) |= _BV(digitalPinToPCMSKbit(intPin));
+        *digitalPinToPCICR(intPin) |= _BV(digitalPinToPCICRbit(intPin));
+
+        // anything already waiting would not cause an edge
+        drain();
+    }
+}
+
+/**
+ * Catch frames the interrupt could not, such as after a missed edge
+ * Call from the main loop
+ */
+void CanReceiver::poll() {
+    if (!held && isPending()) {
+        ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+            drain();
+        }
+    }
+}
+
+/**
+ * Reads every pending frame out of the controller into the ring
+ * Frames are always read, even when the ring is full, so the controller never holds CAN_INT low
+ * Called by the pin-change interrupt and SpiBus, only call with interrupts disabled
+ */
+void CanReceiver::drain() {
+    if (!isPending()) {
+        return;
+    }
+
+    CanFrame frame;
+
+    while (canBus->readMsgBuf(&frame.canId, &frame.len, frame.buf) == CAN_OK) {
+        if (!ring.push(frame)) {
+            droppedFrames++;
+        }
+    }
+
+    readErrorFlags();
+}
+
+/**
+ * Determine whether the controller has frames waiting to be read
+ * @return whether CAN_INT is asserted
+ */
+bool CanReceiver::isPending() {
+    return canBus != nullptr && !digitalRead(canIntPin);
+}
+
+/**
+ * Clears the RX overflow flags in the controller's EFLG register
+ * The mcp_can library has no way to do this, so it is done with a BIT MODIFY instruction
+ */
+void CanReceiver::clearOverflowFlags() {
+    SPI.beginTransaction(SPISettings(MCP_SPI_BAUD, MSBFIRST, SPI_MODE0));
+    digitalWrite(canCsPin, LOW);
+    SPI.transfer(MCP_BITMOD);
+    SPI.transfer(MCP_EFLG);
+    SPI.transfer(MCP_EFLG_RX0OVR | MCP_EFLG_RX1OVR);
+    SPI.transfer(0x00);
+    digitalWrite(canCsPin, HIGH);
+    SPI.endTransaction();
+}
+
+/**
+ * Reads the controller's EFLG register, counting and clearing RX overflows
+ * Only call with interrupts disabled
+ * @return the error flags, MCP_EFLG_*
+ */
+uint8_t CanReceiver::readErrorFlags() {
+    const uint8_t flags = canBus->getError();
+
+    if (flags & (MCP_EFLG_RX0OVR | MCP_EFLG_RX1OVR)) {
+        controllerOverflows++;
+        clearOverflowFlags();
+    }
+
+    return flags;
+}
+
+/**
+ * Hold off the interrupt and poll(), while another device uses the SPI bus, see SpiBus
+ * Only the pin-change interrupt enable is cleared, edges on CAN_INT still latch the pin-change flag,
+ * so the interrupt runs once released
+ */
+void CanReceiver::hold() {
+    if (canBus == nullptr) {
+        return;
+    }
+
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+        *digitalPinToPCICR(canIntPin) &= ~_BV(digitalPinToPCICRbit(canIntPin));
+        held = true;
+    }
+}
+
+/**
+ * Let the interrupt and poll() read the controller again
+ * Only call with interrupts disabled
+ */
+void CanReceiver::release() {
+    if (canBus == nullptr) {
+        return;
+    }
+
+    held = false;
+    *digitalPinToPCICR(canIntPin) |= _BV(digitalPinToPCICRbit(canIntPin));
+}
+
+/**
+ * Read the controller's error flags and error counters
+ * Not possible while held, the SPI bus is busy then
+ * @param state output for the error state
+ * @return false if the controller could not be read
+ */
+bool CanReceiver::readErrorState(CanErrorState& state) {
+    bool read = false;
+
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+        if (canBus != nullptr && !held) {
+            state.flags = readErrorFlags();
+            state.rxErrors = canBus->errorCountRX();
+            state.txErrors = canBus->errorCountTX();
+            read = true;
+        }
+    }
+
+    return read;
+}
+
+/**
+ * Add a frame to the ring as if it was received, for the debug console and benchmarks
+ * The interrupt is the ring's only other producer, so it is held off while pushing
+ * @param frame the frame
+ * @return false if the ring was full and the frame was dropped
+ */
+bool CanReceiver::inject(const CanFrame& frame) {
+    bool pushed;
+
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+        pushed = ring.push(frame);
+
+        if (!pushed) {
+            droppedFrames++;
+        }
+    }
+
+    return pushed;
+}
+
+/**
+ * Take the oldest received frame
+ * @param frame output for the frame
+ * @return false if no frame was waiting
+ */
+bool CanReceiver::pop(CanFrame& frame) {
+    return ring.pop(frame);
+}
+
+/**
+ * Determine whether received frames are waiting to be taken
+ * @return whether pop() would return a frame
+ */
+bool CanReceiver::available() {
+    return !ring.isEmpty();
+}
+
+/**
+ * Number of frames read from the controller but dropped because the ring was full
+ * @return the count
+ */
+uint16_t CanReceiver::getDroppedFrames() {
+    uint16_t count;
+
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+        count = droppedFrames;
+    }
+
+    return count;
+}
+
+/**
+ * Number of times the controller reported an RX buffer overflow, meaning frames were lost before reading
+ * @return the count
+ */
+uint16_t CanReceiver::getControllerOverflows() {
+    uint16_t count;
+
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+        count = controllerOverflows;
+    }
+
+    return count;
+}
+
+/**
+ * Reset the overflow counters
+ */
+void CanReceiver::clearCounters() {
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+        droppedFrames = 0;
+        controllerOverflows = 0;
+    }
+}
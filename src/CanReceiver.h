@@ -0,0 +1,153 @@
+#ifndef CAN_RECEIVER_H
+#define CAN_RECEIVER_H
+
+#include <Arduino.h>
+#include "DataTypes.h" // include before mcp_can to normalize data types
+#include <mcp_can.h>
+#include "RingBuffer.h"
+
+// number of ring slots for received frames, one is always kept free
+#define CAN_RX_RING_SIZE 8
+
+/**
+ * A received CAN frame
+ */
+struct CanFrame {
+    uint32_t canId;
+    uint8_t len;
+    uint8_t buf[8];
+};
+
+/**
+ * Error state of the CAN controller
+ */
+struct CanErrorState {
+    /**
+     * EFLG register, MCP_EFLG_*
+     */
+    uint8_t flags;
+
+    /**
+     * REC register, receive error counter
+     */
+    uint8_t rxErrors;
+
+    /**
+     * TEC register, transmit error counter
+     */
+    uint8_t txErrors;
+};
+
+/**
+ * Interrupt-driven CANBUS reception
+ * CAN_INT falling triggers a pin-change interrupt, which drains every pending MCP25625 RX buffer into a ring
+ * The main loop then consumes frames from the ring whenever it has time
+ */
+class CanReceiver {
+    /**
+     * Clears the RX overflow flags in the controller's EFLG register
+     */
+    static void clearOverflowFlags();
+
+    /**
+     * Reads the controller's EFLG register, counting and clearing RX overflows
+     * Only call with interrupts disabled
+     * @return the error flags, MCP_EFLG_*
+     */
+    static uint8_t readErrorFlags();
+
+public:
+    /**
+     * Start interrupt-driven reception
+     * Controller must already be initialized
+     * @param bus the CAN controller
+     * @param csPin the CAN controller chip select pin
+     * @param intPin the CAN controller interrupt pin, must be on port C (PCINT8-14)
+     */
+    static void begin(MCP_CAN* bus, uint8_t csPin, uint8_t intPin);
+
+    /**
+     * Catch frames the interrupt could not, such as after a missed edge
+     * Call from the main loop
+     */
+    static void poll();
+
+    /**
+     * Reads every pending frame out of the controller into the ring
+     * Called by the pin-change interrupt and SpiBus, only call with interrupts disabled
+     */
+    static void drain();
+
+    /**
+     * Determine whether the controller has frames waiting to be read
+     * @return whether CAN_INT is asserted
+     */
+    [[nodiscard]] static bool isPending();
+
+    /**
+     * Hold off the interrupt and poll(), while another device uses the SPI bus, see SpiBus
+     * Edges on CAN_INT still latch the pin-change flag, so the interrupt runs once released
+     */
+    static void hold();
+
+    /**
+     * Let the interrupt and poll() read the controller again
+     * Only call with interrupts disabled
+     */
+    static void release();
+
+    /**
+     * Read the controller's error flags and error counters
+     * Not possible while held, the SPI bus is busy then
+     * @param state output for the error state
+     * @return false if the controller could not be read
+     */
+    static bool readErrorState(CanErrorState& state);
+
+    /**
+     * Add a frame to the ring as if it was received, for the debug console and benchmarks
+     * @param frame the frame
+     * @return false if the ring was full and the frame was dropped
+     */
+    static bool inject(const CanFrame& frame);
+
+    /**
+     * Take the oldest received frame
+     * @param frame output for the frame
+     * @return false if no frame was waiting
+     */
+    static bool pop(CanFrame& frame);
+
+    /**
+     * Determine whether received frames are waiting to be taken
+     * @return whether pop() would return a frame
+     */
+    [[nodiscard]] static bool available();
+
+    /**
+     * Number of frames the ring can hold
+     * @return the capacity
+     */
+    static constexpr uint8_t capacity() {
+        return RingBuffer<CanFrame, CAN_RX_RING_SIZE>::capacity();
+    }
+
+    /**
+     * Number of frames read from the controller but dropped because the ring was full
+     * @return the count
+     */
+    [[nodiscard]] static uint16_t getDroppedFrames();
+
+    /**
+     * Number of times the controller reported an RX buffer overflow, meaning frames were lost before reading
+     * @return the count
+     */
+    [[nodiscard]] static uint16_t getControllerOverflows();
+
+    /**
+     * Reset the overflow counters
+     */
+    static void clearCounters();
+};
+
+#endif //CAN_RECEIVER_H
@@ -0,0 +1,41 @@
+#ifndef CLOCK_H
+#define CLOCK_H
+
+#include <Arduino.h>
+
+/**
+ * Time source for all firmware logic, use this instead of millis()
+ * On the board this is millis()
+ * Native builds (HAL_NATIVE) follow real time until set, then only move when advanced, so data can be replayed
+ * faster or slower than it was recorded
+ */
+class Clock {
+public:
+    /**
+     * Current time
+     * @return milliseconds since boot
+     */
+    static uint32_t now();
+
+#ifdef HAL_NATIVE
+    /**
+     * Stop following real time, and jump to a time
+     * @param ms the new time
+     */
+    static void set(uint32_t ms);
+
+    /**
+     * Move time forward, only once set() was called
+     * @param ms milliseconds to add
+     */
+    static void advance(uint32_t ms);
+#endif
+};
+
+#ifndef HAL_NATIVE
+inline uint32_t Clock::now() {
+    return millis();
+}
+#endif
+
+#endif //CLOCK_H
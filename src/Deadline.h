@@ -0,0 +1,31 @@
+#ifndef DEADLINE_H
+#define DEADLINE_H
+
+#include <Arduino.h>
+#include "Clock.h"
+
+// returned by getNextDeadline() when nothing will change without new data
+#define RENDERER_NO_DEADLINE 0UL
+
+/**
+ * Turn a Clock::now() timestamp into a deadline
+ * A timestamp which wrapped around to RENDERER_NO_DEADLINE is moved 1 ms later, so it is never read as no deadline
+ * Every deadline must be built with this
+ * @param at Clock::now() timestamp
+ * @return the deadline
+ */
+constexpr uint32_t makeDeadline(uint32_t const at) {
+    return at == RENDERER_NO_DEADLINE ? at + 1 : at;
+}
+
+/**
+ * Determine whether a deadline has passed
+ * @param deadline deadline from makeDeadline(), such as Renderer::getNextDeadline()
+ * @return whether the deadline passed, never true for RENDERER_NO_DEADLINE
+ */
+inline bool isDeadlineDue(uint32_t const deadline) {
+    // subtracting keeps this correct when the clock overflows
+    return deadline != RENDERER_NO_DEADLINE && static_cast<int32_t>(Clock::now() - deadline) >= 0;
+}
+
+#endif //DEADLINE_H
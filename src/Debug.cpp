@@ -2,16 +2,23 @@
 #include "Debug.h"
 #include "Flash.h"
 #include "Watchdog.h"
+#include "CanReceiver.h"
+#include "SpiBus.h"
+#include "Power.h"
+#include "BusMonitor.h"
+#include "BusDiagnostics.h"
+#include "Pipeline.h"
 
-void Debug::processDebugInput(Renderer** renderers, size_t numRenderers) {
+bool Debug::muted = false;
+
+void Debug::processDebugInput(PageFlusher* flusher, GMLanRenderers& renderers) {
 #if DO_DEBUG == 1
     while (Serial && Serial.available()) {
-        Serial.print("\n");
+        Serial.print(F("\n"));
         switch (const auto input = Serial.read(); input) {
             case 'r':
                 Serial.print(F("Rebooting due to user input.\n"));
-                delay(1000);
-                digitalWrite(SW_RESET, LOW);
+                Watchdog::reboot();
             break;
             case 'm':
             case 'i': {
@@ -20,38 +27,92 @@ void Debug::processDebugInput(Renderer** renderers, size_t numRenderers) {
                     : GMLAN_VAL_CLUSTER_UNITS_IMPERIAL;
 
                 Flash::saveUnits(units);
-
-                for (size_t i = 0; i < numRenderers; i++) {
-                    renderers[i]->setUnits(units);
-                }
+                renderers.setUnits(units);
 
                 break;
             }
             case 't': {
-                uint8_t b[] = { 0, 0x72, 0, 0, 0, 0, 0, 0 };
-
-                for (size_t i = 0; i < numRenderers; i++) {
-                    renderers[i]->processMessage(GMLAN_MSG_TEMPERATURE, 2, b);
-                }
+                CanFrame frame = {GMLAN_R_ARB(GMLAN_MSG_TEMPERATURE), 2, { 0, 0x72, 0, 0, 0, 0, 0, 0 }};
+                processCanFrame(frame, renderers);
 
                 break;
             }
             case 'p': {
-                uint8_t b[8] = { GMLAN_VAL_PARK_ASSIST_ON, 0x33, 0x22, 0x00, 0, 0, 0, 0 };
+                CanFrame frame = {GMLAN_R_ARB(GMLAN_MSG_PARK_ASSIST), 2, { GMLAN_VAL_PARK_ASSIST_ON, 0x33, 0x22, 0x00, 0, 0, 0, 0 }};
+                processCanFrame(frame, renderers);
+
+                break;
+            }
+            case 'q': {
+                CanFrame frame = {GMLAN_R_ARB(GMLAN_MSG_PARK_ASSIST), 2, { GMLAN_VAL_PARK_ASSIST_OFF, 0x00, 0x00, 0x00, 0, 0, 0, 0 }};
+                processCanFrame(frame, renderers);
 
-                for (size_t i = 0; i < numRenderers; i++) {
-                    renderers[i]->processMessage(GMLAN_MSG_PARK_ASSIST, 2, b);
+                break;
+            }
+            case 'c':
+                Serial.printf(
+                    F("CAN dropped=%u overflows=%u stale=%u preempted OLED=%u\n"),
+                    CanReceiver::getDroppedFrames(),
+                    CanReceiver::getControllerOverflows(),
+                    getStaleFrames(),
+                    SpiBus::getPreemptions()
+                );
+                CanReceiver::clearCounters();
+                clearStaleFrames();
+                SpiBus::clearCounters();
+                break;
+            case 'z': {
+                const PowerStats stats = Power::getStats();
+                Serial.printf(
+                    F("Power asleep=%u%% est=%luuA wakes=%u max wake=%uus display on=%u\n"),
+                    Power::asleepPercent(stats),
+                    Power::estimateMicroamps(stats),
+                    stats.wakes,
+                    stats.maxWakeUs,
+                    flusher->isDisplayOn()
+                );
+                Power::clearStats();
+                break;
+            }
+            case 'n': {
+                const BusStats& stats = BusMonitor::getStats();
+                Serial.print(F("Bus"));
+
+                for (uint8_t i = 0; i < GMLanRegistry::numArbIds; i++) {
+                    Serial.printf(F(" 0x%03lx=%u/s"), GMLanRegistry::arbIdOf(i), stats.framesPerSecond[i]);
                 }
 
+                Serial.printf(
+                    F(" unrecognized=%u EFLG=0x%02x REC=%u TEC=%u error-passive=%u bus-off=%u\n"),
+                    stats.unrecognized,
+                    stats.errors.flags,
+                    stats.errors.rxErrors,
+                    stats.errors.txErrors,
+                    stats.errorPassive,
+                    stats.busOff
+                );
+                BusMonitor::clearCounters();
                 break;
             }
-            case 'q': {
-                uint8_t b[8] = { GMLAN_VAL_PARK_ASSIST_OFF, 0x00, 0x00, 0x00, 0, 0, 0, 0 };
+            case 'd':
+                BusDiagnostics::setEnabled(!BusDiagnostics::isEnabled());
+                break;
+            case 'w': {
+                const ResetRecord& reset = Flash::getResetRecord();
+                Serial.printf(
+                    F("Watchdog loop overruns=%u longest=%ums, last reset cause=%u stage=%u count=%u\n"),
+                    Watchdog::getOverruns(),
+                    Watchdog::getLongestLoopMs(),
+                    reset.cause,
+                    reset.stage,
+                    reset.count
+                );
 
-                for (size_t i = 0; i < numRenderers; i++) {
-                    renderers[i]->processMessage(GMLAN_MSG_PARK_ASSIST, 2, b);
+                if (isFirstFrameShown()) {
+                    Serial.printf(F("First frame shown %lums after boot\n"), getFirstFrameAt());
                 }
 
+                Watchdog::clearStats();
                 break;
             }
             default:
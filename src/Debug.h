@@ -2,16 +2,22 @@
 #define DEBUG_H
 
 #if DO_DEBUG == 1
-    #define DEBUG(X) X
+    #define DEBUG(X) do { if (!Debug::muted) { X; } } while (0)
 #else
     #define DEBUG(X)
 #endif
 
-#include <Renderer.h>
+#include "PageFlusher.h"
+#include "GMLanRenderers.h"
 
 class Debug {
 public:
-    static void processDebugInput(Renderer** renderers, size_t numRenderers);
+    /**
+     * Silences DEBUG() and TELEMETRY() output, so timing isn't dominated by the serial port
+     */
+    static bool muted;
+
+    static void processDebugInput(PageFlusher* flusher, GMLanRenderers& renderers);
 };
 
 
@@ -1,46 +1,401 @@
 #include <EEPROM.h>
 
 #include "Flash.h"
+#include "Clock.h"
 #include "Debug.h"
+#include "Telemetry.h"
 
-static constexpr uint8_t header[4] = {0x01, 0xCC, 0x10, 0xF7};
+/*
+ * Record layout: 2 byte sequence number, FlashSettings, 2 byte CRC-16 over everything before it, little-endian
+ * The newest record is the valid one with the highest sequence number, compared with wraparound
+ */
+static constexpr uint8_t SEQUENCE_SIZE = 2;
+static constexpr uint8_t CHECKSUM_SIZE = 2;
+static constexpr uint8_t RECORD_SIZE = SEQUENCE_SIZE + sizeof(FlashSettings) + CHECKSUM_SIZE;
+static constexpr uint8_t CHECKSUM_INDEX = RECORD_SIZE - CHECKSUM_SIZE;
+static constexpr uint8_t CRC_INIT = 0xFF;
+static constexpr uint16_t CRC16_INIT = 0xFFFF;
+static constexpr FlashSettings DEFAULT_SETTINGS = {0, 0, 0};
 
-// note index must start at 4 to leave room for header
-static constexpr size_t UNITS_INDEX = 4;
-static constexpr uint8_t UNITS_DEFAULT = 0;
+/*
+ * Previous record layout: 2 byte sequence number, units, 1 byte CRC-8
+ * Its records start at other offsets, and a 1 byte checksum lets about 1 in 256 of them pass for a record of the
+ * current layout, so the current one has a 2 byte checksum, and is only looked for first
+ */
+static constexpr uint8_t PREVIOUS_RECORD_SIZE = SEQUENCE_SIZE + 1 + 1;
+static constexpr uint8_t PREVIOUS_CHECKSUM_INDEX = PREVIOUS_RECORD_SIZE - 1;
+static_assert(PREVIOUS_RECORD_SIZE <= RECORD_SIZE, "a previous record must fit the buffer of a current one");
 
-bool Flash::isSetUp() {
-    const auto headerLen = static_cast<size_t>(sizeof(header) / sizeof(header[0]));
+// reset record: ResetRecord, 1 byte checksum, in the last bytes of EEPROM
+static constexpr uint8_t RESET_RECORD_SIZE = sizeof(ResetRecord) + 1;
+static constexpr ResetRecord NO_RESET_RECORD = {0, 0, 0};
 
-    for (size_t i = 0; i < headerLen; i++) {
-        if (EEPROM.read(i) != header[i]) {
-            return false;
+// pre-record format: fixed header, then units at a fixed index
+static constexpr uint8_t LEGACY_HEADER[4] = {0x01, 0xCC, 0x10, 0xF7};
+static constexpr uint8_t LEGACY_UNITS_INDEX = 4;
+
+static FlashSettings settings = DEFAULT_SETTINGS;
+static FlashSettings stored = DEFAULT_SETTINGS; // as in the newest record, a commit which would repeat it is skipped
+static uint16_t sequence = 0;
+static uint16_t slot = 0;
+static ResetRecord resetRecord = NO_RESET_RECORD;
+
+// commit state, record is a snapshot so changes during a write start another commit
+static bool changed = false;
+static uint32_t changedAt = 0;
+static uint8_t record[RECORD_SIZE];
+static uint8_t recordIndex = RECORD_SIZE; // RECORD_SIZE when no write is in progress
+
+/**
+ * CRC-8, polynomial 0x07
+ * @param data the bytes
+ * @param len number of bytes
+ * @return the checksum
+ */
+static constexpr uint8_t crc8(const uint8_t* data, uint8_t const len) {
+    uint8_t crc = CRC_INIT;
+
+    for (uint8_t i = 0; i < len; i++) {
+        crc ^= data[i];
+
+        for (uint8_t bit = 0; bit < 8; bit++) {
+            crc = crc & 0x80 ? static_cast<uint8_t>((crc << 1) ^ 0x07) : static_cast<uint8_t>(crc << 1);
+        }
+    }
+
+    return crc;
+}
+
+/**
+ * CRC-16/CCITT-FALSE, polynomial 0x1021
+ * @param data the bytes
+ * @param len number of bytes
+ * @return the checksum
+ */
+static constexpr uint16_t crc16(const uint8_t* data, uint8_t const len) {
+    uint16_t crc = CRC16_INIT;
+
+    for (uint8_t i = 0; i < len; i++) {
+        crc ^= static_cast<uint16_t>(data[i] << 8);
+
+        for (uint8_t bit = 0; bit < 8; bit++) {
+            crc = crc & 0x8000 ? static_cast<uint16_t>((crc << 1) ^ 0x1021) : static_cast<uint16_t>(crc << 1);
+        }
+    }
+
+    return crc;
+}
+
+/**
+ * Checksum of a record with every byte set to the same value
+ * @param value the byte value
+ * @return the checksum of the record's first CHECKSUM_INDEX bytes
+ */
+static constexpr uint16_t uniformChecksum(uint8_t const value) {
+    uint8_t data[RECORD_SIZE] = {};
+
+    for (uint8_t i = 0; i < CHECKSUM_INDEX; i++) {
+        data[i] = value;
+    }
+
+    return crc16(data, CHECKSUM_INDEX);
+}
+
+static_assert(uniformChecksum(0xFF) != 0xFFFF, "an erased slot must not be a valid record");
+static_assert(uniformChecksum(0x00) != 0x0000, "a zeroed slot must not be a valid record");
+
+static constexpr uint8_t ERASED_RESET_RECORD[sizeof(ResetRecord)] = {0xFF, 0xFF, 0xFF};
+static_assert(crc8(ERASED_RESET_RECORD, sizeof(ResetRecord)) != 0xFF, "an erased reset record must not be valid");
+
+/**
+ * Number of record slots in EEPROM
+ * The reset record comes after the last slot, so a record written by older firmware in that slot is ignored
+ * @param recordSize size of a record, RECORD_SIZE unless looking for records of the previous layout
+ * @return the count
+ */
+static uint16_t slotCount(uint8_t const recordSize = RECORD_SIZE) {
+    return (EEPROM.length() - RESET_RECORD_SIZE) / recordSize;
+}
+
+/**
+ * Determine whether a record of the current layout is intact
+ * @param data RECORD_SIZE bytes
+ * @return whether its checksum matches
+ */
+static bool isValidRecord(const uint8_t* data) {
+    return crc16(data, CHECKSUM_INDEX) == static_cast<uint16_t>(data[CHECKSUM_INDEX] | data[CHECKSUM_INDEX + 1] << 8);
+}
+
+/**
+ * Determine whether a record of the previous layout is intact
+ * @param data PREVIOUS_RECORD_SIZE bytes
+ * @return whether its checksum matches
+ */
+static bool isValidPreviousRecord(const uint8_t* data) {
+    return crc8(data, PREVIOUS_CHECKSUM_INDEX) == data[PREVIOUS_CHECKSUM_INDEX];
+}
+
+/**
+ * Find the newest valid record of a layout
+ * @param recordSize size of the layout's records, at most RECORD_SIZE
+ * @param isValid checks a record of the layout
+ * @param newest receives the newest record, RECORD_SIZE bytes
+ * @param newestSlot receives its slot
+ * @param newestSequence receives its sequence number
+ * @return whether one was found
+ */
+static bool findNewest(
+    uint8_t const recordSize,
+    bool (*isValid)(const uint8_t*),
+    uint8_t* newest,
+    uint16_t& newestSlot,
+    uint16_t& newestSequence
+) {
+    bool found = false;
+    uint8_t data[RECORD_SIZE];
+
+    for (uint16_t i = 0; i < slotCount(recordSize); i++) {
+        for (uint8_t j = 0; j < recordSize; j++) {
+            data[j] = EEPROM.read(i * recordSize + j);
+        }
+
+        if (!isValid(data)) {
+            continue;
+        }
+
+        const auto recordSequence = static_cast<uint16_t>(data[0] | data[1] << 8);
+
+        // subtracting keeps this correct when the sequence number overflows
+        if (!found || static_cast<int16_t>(recordSequence - newestSequence) > 0) {
+            found = true;
+            newestSequence = recordSequence;
+            newestSlot = i;
+            memcpy(newest, data, recordSize);
+        }
+    }
+
+    return found;
+}
+
+/**
+ * EEPROM address of the reset record
+ * @return the address
+ */
+static uint16_t resetRecordAddress() {
+    return EEPROM.length() - RESET_RECORD_SIZE;
+}
+
+/**
+ * Load the reset record, or fall back to none
+ */
+static void loadResetRecord() {
+    uint8_t data[RESET_RECORD_SIZE];
+
+    for (uint8_t i = 0; i < RESET_RECORD_SIZE; i++) {
+        data[i] = EEPROM.read(resetRecordAddress() + i);
+    }
+
+    if (crc8(data, sizeof(ResetRecord)) == data[sizeof(ResetRecord)]) {
+        memcpy(&resetRecord, data, sizeof(resetRecord));
+    } else {
+        resetRecord = NO_RESET_RECORD;
+    }
+}
+
+/**
+ * Find the newest valid record and load it, or fall back to defaults
+ * EEPROM written with the previous record layout, or the old fixed-header format, has its units carried over
+ */
+void Flash::load() {
+    uint8_t data[RECORD_SIZE];
+
+    if (findNewest(RECORD_SIZE, isValidRecord, data, slot, sequence)) {
+        memcpy(&settings, data + SEQUENCE_SIZE, sizeof(settings));
+        stored = settings;
+        return;
+    }
+
+    // newest record is written to the slot after this one, so start at the beginning
+    slot = slotCount() - 1;
+    settings = DEFAULT_SETTINGS;
+    uint16_t previousSlot;
+
+    if (findNewest(PREVIOUS_RECORD_SIZE, isValidPreviousRecord, data, previousSlot, sequence)) {
+        settings.units = data[SEQUENCE_SIZE];
+        markChanged();
+        return;
+    }
+
+    for (uint8_t i = 0; i < sizeof(LEGACY_HEADER); i++) {
+        if (EEPROM.read(i) != LEGACY_HEADER[i]) {
+            return;
         }
     }
 
-    return true;
+    settings.units = EEPROM.read(LEGACY_UNITS_INDEX);
+    markChanged();
 }
 
-void Flash::setDefaults() {
-    const auto headerLen = static_cast<size_t>(sizeof(header) / sizeof(header[0]));
+/**
+ * Load settings from EEPROM, must be called before anything else
+ */
+void Flash::begin() {
+    load();
+    loadResetRecord();
 
-    if (!isSetUp()) {
-        for (size_t i = 0; i < headerLen; i++) {
-            EEPROM.write(i, header[i]);
+    // the temperature is one power-up older, this is only written if live data does not replace it first
+    if (settings.temperature != 0 && settings.temperatureAge < UINT8_MAX) {
+        settings.temperatureAge++;
+        markChanged();
+    }
+
+    DEBUG(Serial.printf(
+        F("Flash() units=%x temperature=%x age=%u sequence=%u slot=%u\n"),
+        settings.units,
+        settings.temperature,
+        settings.temperatureAge,
+        sequence,
+        slot
+    ));
+}
+
+/**
+ * Mark settings as changed, starting the commit delay
+ */
+void Flash::markChanged() {
+    changed = true;
+    changedAt = Clock::now();
+}
+
+/**
+ * Write the next byte of a pending record, if one is due and the EEPROM is ready
+ * A byte write takes ~3.3ms, but only blocks if the previous one is still running, which is checked first
+ * Call from the main loop
+ */
+void Flash::commit() {
+    if (recordIndex == RECORD_SIZE) {
+        if (!changed || Clock::now() - changedAt < FLASH_COMMIT_DELAY_MS) {
+            return;
         }
 
-        EEPROM.write(UNITS_INDEX, UNITS_DEFAULT);
+        changed = false;
+
+        // changed back before it was written, such as a temperature aged at boot then shown again
+        if (memcmp(&settings, &stored, sizeof(settings)) == 0) {
+            return;
+        }
+
+        // snapshot the settings into the next record
+        stored = settings;
+        sequence++;
+        slot = (slot + 1) % slotCount();
+        record[0] = static_cast<uint8_t>(sequence);
+        record[1] = static_cast<uint8_t>(sequence >> 8);
+        memcpy(record + SEQUENCE_SIZE, &settings, sizeof(settings));
+        const uint16_t checksum = crc16(record, CHECKSUM_INDEX);
+        record[CHECKSUM_INDEX] = static_cast<uint8_t>(checksum);
+        record[CHECKSUM_INDEX + 1] = static_cast<uint8_t>(checksum >> 8);
+        recordIndex = 0;
+    }
+
+    if (!eeprom_is_ready()) {
+        return;
     }
 
-    DEBUG(Serial.printf("Flash() units=%x\n", getUnits()));
+    EEPROM.update(slot * RECORD_SIZE + recordIndex, record[recordIndex]);
+    recordIndex++;
+
+    if (recordIndex == RECORD_SIZE) {
+        TELEMETRY(FLASH_COMMITTED, sequence, slot);
+    }
+}
+
+/**
+ * Determine whether settings changed and are not fully written yet
+ * @return whether a commit is pending or in progress
+ */
+bool Flash::isCommitPending() {
+    return changed || recordIndex < RECORD_SIZE;
 }
 
+/**
+ * Change the units, only changes are written
+ * @param newUnits the new unit data (GMLAN_VAL_CLUSTER_UNITS_*)
+ */
 void Flash::saveUnits(const uint8_t newUnits) {
-    EEPROM.write(UNITS_INDEX, newUnits);
+    if (newUnits == settings.units) {
+        return;
+    }
+
+    settings.units = newUnits;
+    markChanged();
 
-    DEBUG(Serial.printf("saveUnits() units=%x\n", getUnits()));
+    TELEMETRY(UNITS_SAVED, newUnits);
 }
 
+/**
+ * Get the units
+ * @return the unit data (GMLAN_VAL_CLUSTER_UNITS_*)
+ */
 uint8_t Flash::getUnits() {
-    return EEPROM.read(UNITS_INDEX);
+    return settings.units;
+}
+
+/**
+ * Change the last shown temperature, only changes are written
+ * Resets its age, so only call with live data
+ * @param newTemperature the raw TEMPERATURE signal
+ */
+void Flash::saveTemperature(uint8_t const newTemperature) {
+    if (newTemperature == settings.temperature && settings.temperatureAge == 0) {
+        return;
+    }
+
+    settings.temperature = newTemperature;
+    settings.temperatureAge = 0;
+    markChanged();
+
+    TELEMETRY(TEMPERATURE_SAVED, newTemperature);
+}
+
+/**
+ * Get the last shown temperature
+ * @return the raw TEMPERATURE signal, 0 if none was saved
+ */
+uint8_t Flash::getTemperature() {
+    return settings.temperature;
+}
+
+/**
+ * Get the age of the last shown temperature
+ * There is no clock across power-off, so age is counted in power-ups, 1 if it was shown before this one
+ * @return power-ups since it was shown, 255 or more is 255
+ */
+uint8_t Flash::getTemperatureAge() {
+    return settings.temperatureAge;
+}
+
+/**
+ * Write the reset record, only changed bytes are written
+ * Writes at once, waiting on the EEPROM, so only call during boot before commit() runs
+ * @param newRecord the reset record
+ */
+void Flash::saveResetRecord(const ResetRecord& newRecord) {
+    uint8_t data[RESET_RECORD_SIZE];
+    memcpy(data, &newRecord, sizeof(newRecord));
+    data[sizeof(ResetRecord)] = crc8(data, sizeof(ResetRecord));
+
+    for (uint8_t i = 0; i < RESET_RECORD_SIZE; i++) {
+        EEPROM.update(resetRecordAddress() + i, data[i]);
+    }
+
+    resetRecord = newRecord;
+}
+
+/**
+ * Get the reset record, as loaded by begin() or last saved
+ * @return the reset record
+ */
+const ResetRecord& Flash::getResetRecord() {
+    return resetRecord;
 }
@@ -3,12 +3,109 @@
 
 #include <Arduino.h>
 
+// time without further changes before settings are committed, so bursts of changes cost one record
+#define FLASH_COMMIT_DELAY_MS 2000UL
+
+/**
+ * Persisted settings, one copy is kept in RAM and committed as a whole record
+ */
+struct FlashSettings {
+    uint8_t units;
+    uint8_t temperature;    // raw TEMPERATURE signal last shown, 0 for none
+    uint8_t temperatureAge; // power-ups since the temperature was last shown from live data, stops at 255
+};
+
+/**
+ * Why the MCU last reset, other than by power-on, see Watchdog::logReset()
+ * A record with count 0 means no such reset was recorded
+ */
+struct ResetRecord {
+    uint8_t cause; // ResetCause
+    uint8_t stage; // WatchdogStage when it happened
+    uint8_t count; // number of such resets so far, stops at 255
+};
+
+/**
+ * Persistent settings store
+ * Settings are read from RAM, and only written to EEPROM when they change, after FLASH_COMMIT_DELAY_MS
+ * Each commit writes a new record to the next slot in a ring across EEPROM, with a sequence number and checksum,
+ * so wear is spread over every slot and an interrupted write leaves the previous record intact
+ * Records are written one byte per commit() call, only when the EEPROM is ready, so the caller never waits on it
+ * The last bytes of EEPROM are kept out of the ring for a ResetRecord, which is rarely written
+ */
 class Flash {
-    static bool isSetUp();
+    /**
+     * Find the newest valid record and load it, or fall back to defaults
+     */
+    static void load();
+
+    /**
+     * Mark settings as changed, starting the commit delay
+     */
+    static void markChanged();
+
 public:
-    static void setDefaults();
+    /**
+     * Load settings from EEPROM, must be called before anything else
+     */
+    static void begin();
+
+    /**
+     * Write the next byte of a pending record, if one is due and the EEPROM is ready
+     * Call from the main loop
+     */
+    static void commit();
+
+    /**
+     * Determine whether settings changed and are not fully written yet
+     * @return whether a commit is pending or in progress
+     */
+    [[nodiscard]] static bool isCommitPending();
+
+    /**
+     * Change the units, only changes are written
+     * @param newUnits the new unit data (GMLAN_VAL_CLUSTER_UNITS_*)
+     */
     static void saveUnits(uint8_t newUnits);
-    [[nodiscard]] static uint8_t getUnits() ;
+
+    /**
+     * Get the units
+     * @return the unit data (GMLAN_VAL_CLUSTER_UNITS_*)
+     */
+    [[nodiscard]] static uint8_t getUnits();
+
+    /**
+     * Change the last shown temperature, only changes are written
+     * Resets its age, so only call with live data
+     * @param newTemperature the raw TEMPERATURE signal
+     */
+    static void saveTemperature(uint8_t newTemperature);
+
+    /**
+     * Get the last shown temperature
+     * @return the raw TEMPERATURE signal, 0 if none was saved
+     */
+    [[nodiscard]] static uint8_t getTemperature();
+
+    /**
+     * Get the age of the last shown temperature
+     * There is no clock across power-off, so age is counted in power-ups, 1 if it was shown before this one
+     * @return power-ups since it was shown, 255 or more is 255
+     */
+    [[nodiscard]] static uint8_t getTemperatureAge();
+
+    /**
+     * Write the reset record, only changed bytes are written
+     * Writes at once, waiting on the EEPROM, so only call during boot before commit() runs
+     * @param newRecord the reset record
+     */
+    static void saveResetRecord(const ResetRecord& newRecord);
+
+    /**
+     * Get the reset record, as loaded by begin() or last saved
+     * @return the reset record
+     */
+    [[nodiscard]] static const ResetRecord& getResetRecord();
 };
 
 #endif //FLASH_H
@@ -0,0 +1,88 @@
+#ifndef FRAME_COALESCER_H
+#define FRAME_COALESCER_H
+
+#include <Arduino.h>
+
+#include "ArbRegistry.h"
+#include "CanReceiver.h"
+#include "GMLan.h"
+
+/**
+ * Keeps only the newest frame of each ARB ID, between taking frames from the ring and dispatching them
+ * Every registered ARB ID carries state, such as a distance or a temperature, rather than events,
+ * so a frame superseded before it was dispatched would never have been seen on the display
+ * Frames are dispatched in registry order, not arrival order
+ * @tparam Registry the ArbRegistry whose ARB IDs are kept
+ */
+template<typename Registry>
+class FrameCoalescer {
+    static_assert(Registry::numArbIds <= 8, "FrameCoalescer keeps one bit per ARB ID");
+
+    /**
+     * Newest frame of each ARB ID, indexed by ArbRegistry::indexOf()
+     */
+    CanFrame latest[Registry::numArbIds];
+
+    /**
+     * Bit N set means latest[N] holds a frame which was not dispatched yet
+     */
+    uint8_t present = 0;
+
+    /**
+     * Number of frames replaced by a newer frame of the same ARB ID before being dispatched
+     */
+    uint16_t superseded = 0;
+
+public:
+    /**
+     * Keep a frame, replacing an undispatched frame of the same ARB ID
+     * Frames of ARB IDs which are not in the registry are dropped, nothing would handle them
+     * @param frame the frame
+     */
+    void add(const CanFrame& frame) {
+        const uint8_t index = Registry::indexOf(GMLAN_ARB(frame.canId));
+
+        if (index == ARB_REGISTRY_NO_INDEX) {
+            return;
+        }
+
+        if (present & _BV(index)) {
+            superseded++;
+        }
+
+        latest[index] = frame;
+        present |= _BV(index);
+    }
+
+    /**
+     * Hand every kept frame to fn, then forget them
+     * @tparam Fn callable taking CanFrame&
+     * @param fn
+     */
+    template<typename Fn>
+    void dispatch(Fn fn) {
+        for (uint8_t index = 0; present != 0; index++) {
+            if (present & _BV(index)) {
+                present &= ~_BV(index);
+                fn(latest[index]);
+            }
+        }
+    }
+
+    /**
+     * Number of frames replaced by a newer frame of the same ARB ID before being dispatched
+     * @return the count
+     */
+    [[nodiscard]] uint16_t getSuperseded() const {
+        return superseded;
+    }
+
+    /**
+     * Reset the superseded counter
+     */
+    void clearCounters() {
+        superseded = 0;
+    }
+};
+
+#endif //FRAME_COALESCER_H
@@ -0,0 +1,23 @@
+#ifndef GMLAN_RENDERERS_H
+#define GMLAN_RENDERERS_H
+
+class GMParkAssist;
+class GMTemperature;
+
+template<typename... Renderers>
+class RendererPipeline;
+
+/*
+ * Every renderer, in order of priority, with most important renderer first
+ * Only declared here, so headers can take the pipeline without including every renderer, see Pipeline.h
+ * The diagnostics page is only built with the debug console which turns it on
+ */
+#if DO_DEBUG == 1
+class BusDiagnostics;
+
+using GMLanRenderers = RendererPipeline<GMParkAssist, BusDiagnostics, GMTemperature>;
+#else
+using GMLanRenderers = RendererPipeline<GMParkAssist, GMTemperature>;
+#endif
+
+#endif //GMLAN_RENDERERS_H
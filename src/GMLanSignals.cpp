@@ -0,0 +1,27 @@
+#include "GMLanSignals.h"
+
+/*
+ * Compile-time checks of the signal table
+ */
+
+/**
+ * Compare every temperature byte decoded by the table with Units::rawToCelsius()
+ * GMTemperature keeps the raw byte and converts it with Units, so both must agree on the encoding
+ * @return whether all match
+ */
+static constexpr bool checkTemperature() {
+    for (uint16_t raw = 0; raw <= 0xFF; raw++) {
+        if (GMLanSignals::scaled<GMLanSignal::TEMPERATURE>(raw) != Units::rawToCelsius(raw)) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+static_assert(checkTemperature(), "TEMPERATURE signal differs from Units::rawToCelsius()");
+static_assert(GMLanSignals::unitOf(GMLanSignal::TEMPERATURE) == SignalUnit::CELSIUS, "Units expects Celsius");
+static_assert(
+    GMLanSignals::unitOf(GMLanSignal::PARK_ASSIST_DISTANCE) == SignalUnit::CENTIMETERS,
+    "Units::centimetersToInches() expects centimeters"
+);
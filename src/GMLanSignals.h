@@ -0,0 +1,205 @@
+#ifndef GMLAN_SIGNALS_H
+#define GMLAN_SIGNALS_H
+
+#include <Arduino.h>
+#include "GMLan.h"
+#include "Units.h"
+
+/*
+ * Every GMLAN signal the firmware decodes, see GMLanSignals
+ * X(name, ARB ID, byte, bit, bits, scale, divisor, offset, unit)
+ *
+ * byte is the first byte of the signal and bit its lowest bit, counted from bit 0 of its last byte
+ * A signal of up to 16 bits may span two bytes, which are big-endian like everything on GMLAN
+ * The decoded value is raw * scale / divisor + offset in unit, rounded half away from zero
+ * Adding a signal is one line here, consumers then declare its ARB ID with GMLanSignals::arbIdOf()
+ */
+#define GMLAN_SIGNALS(X) \
+    X(PARK_ASSIST_STATE,    GMLAN_MSG_PARK_ASSIST,   0, 0, 4, 1, 1, 0,   NONE) \
+    X(PARK_ASSIST_DISTANCE, GMLAN_MSG_PARK_ASSIST,   1, 0, 8, 1, 1, 0,   CENTIMETERS) \
+    X(PARK_ASSIST_MIDDLE,   GMLAN_MSG_PARK_ASSIST,   2, 4, 4, 1, 1, 0,   NONE) \
+    X(PARK_ASSIST_RIGHT,    GMLAN_MSG_PARK_ASSIST,   2, 0, 4, 1, 1, 0,   NONE) \
+    X(PARK_ASSIST_LEFT,     GMLAN_MSG_PARK_ASSIST,   3, 0, 4, 1, 1, 0,   NONE) \
+    X(TEMPERATURE,          GMLAN_MSG_TEMPERATURE,   1, 0, 8, 1, 2, -40, CELSIUS) \
+    X(CLUSTER_UNITS,        GMLAN_MSG_CLUSTER_UNITS, 0, 0, 4, 1, 1, 0,   NONE)
+
+/**
+ * Unit of a decoded signal
+ * NONE is for states and levels, compared with the GMLAN_VAL_* constants
+ */
+enum class SignalUnit : uint8_t {
+    NONE,
+    CELSIUS,
+    CENTIMETERS,
+};
+
+/**
+ * Where a signal is in its frame, and how its raw bits map to a value
+ */
+struct SignalDefinition {
+    uint32_t arbId;
+    uint8_t byte;
+    uint8_t bit;
+    uint8_t bits;
+    int16_t scale;
+    int16_t divisor;
+    int16_t offset;
+    SignalUnit unit;
+};
+
+/**
+ * Every GMLAN signal, in the order of GMLAN_SIGNALS
+ */
+enum class GMLanSignal : uint8_t {
+#define GMLAN_SIGNAL_ID(name, arbId, byte, bit, bits, scale, divisor, offset, unit) name,
+    GMLAN_SIGNALS(GMLAN_SIGNAL_ID)
+#undef GMLAN_SIGNAL_ID
+};
+
+/**
+ * Type of a signal's raw bits
+ * @tparam Wide whether the signal has more than 8 bits
+ */
+template<bool Wide>
+struct SignalRaw {
+    using type = uint8_t;
+};
+
+template<>
+struct SignalRaw<true> {
+    using type = uint16_t;
+};
+
+/**
+ * Decodes the signals in GMLAN_SIGNALS straight from frame data
+ * Every definition is a compile-time constant, so reading a signal compiles to loading its bytes, then a shift and
+ * a mask where its bits need them, the same code as masking the frame by hand, with nothing parsed at runtime
+ */
+class GMLanSignals {
+    /**
+     * Every definition, indexed by GMLanSignal
+     */
+    static constexpr SignalDefinition definitions[] = {
+#define GMLAN_SIGNAL_DEFINITION(name, arbId, byte, bit, bits, scale, divisor, offset, unit) \
+        {arbId, byte, bit, bits, scale, divisor, offset, SignalUnit::unit},
+        GMLAN_SIGNALS(GMLAN_SIGNAL_DEFINITION)
+#undef GMLAN_SIGNAL_DEFINITION
+    };
+
+public:
+    /**
+     * Number of signals
+     */
+    static constexpr uint8_t count = sizeof(definitions) / sizeof(definitions[0]);
+
+    /**
+     * Definition of a signal
+     * @param signal the signal
+     * @return its definition
+     */
+    static constexpr SignalDefinition definition(GMLanSignal const signal) {
+        return definitions[static_cast<uint8_t>(signal)];
+    }
+
+    /**
+     * ARB ID of the frame which carries a signal, for the ARB_IDS of its consumers, see ArbRegistry
+     * @param signal the signal
+     * @return the ARB ID
+     */
+    static constexpr uint32_t arbIdOf(GMLanSignal const signal) {
+        return definition(signal).arbId;
+    }
+
+    /**
+     * Unit of a signal's decoded value
+     * @param signal the signal
+     * @return the unit
+     */
+    static constexpr SignalUnit unitOf(GMLanSignal const signal) {
+        return definition(signal).unit;
+    }
+
+    /**
+     * Type of a signal's raw bits, uint8_t for up to 8 bits
+     * @tparam Signal the signal
+     */
+    template<GMLanSignal Signal>
+    using Raw = typename SignalRaw<(definition(Signal).bits > 8)>::type;
+
+    /**
+     * Read a signal's raw bits
+     * @tparam Signal the signal
+     * @param buf frame data
+     * @return the bits, shifted down to bit 0
+     */
+    template<GMLanSignal Signal>
+    static Raw<Signal> raw(const uint8_t buf[8]) {
+        constexpr SignalDefinition signal = definition(Signal);
+        constexpr uint8_t bytes = (signal.bit + signal.bits + 7) / 8;
+        constexpr auto mask = static_cast<uint16_t>((1UL << signal.bits) - 1);
+
+        static_assert(signal.bits > 0 && bytes <= 2 && signal.byte + bytes <= 8, "signal must be in 2 bytes of 8");
+
+        uint16_t value = buf[signal.byte];
+
+        if constexpr (bytes == 2) {
+            value = static_cast<uint16_t>(value << 8 | buf[signal.byte + 1]);
+        }
+
+        return static_cast<Raw<Signal>>((value >> signal.bit) & mask);
+    }
+
+    /**
+     * Convert a signal's raw bits to its value
+     * @tparam Signal the signal
+     * @param raw the bits, as from raw()
+     * @return raw * scale / divisor + offset, rounded half away from zero
+     */
+    template<GMLanSignal Signal>
+    static constexpr int16_t scaled(uint16_t const raw) {
+        constexpr SignalDefinition signal = definition(Signal);
+        constexpr long lowest = static_cast<long>(signal.offset) * signal.divisor;
+        constexpr long highest = ((1L << signal.bits) - 1) * signal.scale + lowest;
+
+        static_assert(signal.divisor > 0, "signal divisor must be positive");
+        static_assert(
+            lowest >= INT16_MIN && lowest <= INT16_MAX && highest >= INT16_MIN && highest <= INT16_MAX,
+            "signal must be scaled in 16 bits"
+        );
+
+        if constexpr (signal.divisor == 1) {
+            return static_cast<int16_t>(raw * signal.scale + signal.offset);
+        } else {
+            return Units::roundedDivide(static_cast<int16_t>(raw * signal.scale + signal.offset * signal.divisor), signal.divisor);
+        }
+    }
+
+    /**
+     * Read a signal's value
+     * @tparam Signal the signal
+     * @param buf frame data
+     * @return the value, in unitOf(Signal)
+     */
+    template<GMLanSignal Signal>
+    static int16_t value(const uint8_t buf[8]) {
+        return scaled<Signal>(raw<Signal>(buf));
+    }
+
+    /**
+     * Determine whether every signal is carried by a frame a registry receives
+     * @tparam Registry the ArbRegistry
+     * @return whether none is left out
+     */
+    template<typename Registry>
+    static constexpr bool receivedBy() {
+        for (const SignalDefinition& signal : definitions) {
+            if (!Registry::contains(signal.arbId)) {
+                return false;
+            }
+        }
+
+        return true;
+    }
+};
+
+#endif //GMLAN_SIGNALS_H
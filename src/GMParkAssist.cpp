@@ -1,92 +1,135 @@
 #include <Arduino.h>
-#include <math.h>
-#include <Adafruit_GFX.h>
-#include <Adafruit_SSD1306.h>
-#include <Fonts/FreeSans9pt7b.h>
 
-#include "Debug.h"
+#include "Telemetry.h"
 #include "GMParkAssist.h"
-#include "TextHelper.h"
+#include "TextTables.h"
+#include "Units.h"
 #include "OLED.h"
 #include "GMLan.h"
+#include "Clock.h"
+
+/*
+ * Blink period and visible part of each period, by level
+ * Note only indexes 1 through 4 are used, level 1 is solid
+ */
+static const uint16_t PA_BLINK_PERIOD[5] PROGMEM = {1U, 1U, 300U, 650U, 1000U};
+static const uint16_t PA_BLINK_VISIBLE[5] PROGMEM = {1U, 1U, 150U, 325U, 500U};
 
 /**
- * Renders the Park Assist rectangle, blanking out the rectangle zone first
- * Rectangle will be rendered visible or invisible based on millis()
- * Does not update display
+ * Rectangle of a slot, along the bottom of the region
+ * Columns left over by the slots are split between both sides, an odd one widens every rectangle by a column
+ * @param slot the slot [0...4]
+ * @return the rectangle
  */
-void GMParkAssist::renderMarkerRectangle() const {
-    const auto now = millis();
-    display->fillRect(
-        0,
-        SCREEN_HEIGHT - PA_BAR_H,
-        SCREEN_WIDTH,
-        PA_BAR_H,
-        SSD1306_BLACK
-    );
+Region GMParkAssist::getMarker(uint8_t const slot) const {
+    const uint8_t spare = region.w % PA_SLOTS;
 
-    if (
-        parkAssistLevel > 0
-        && parkAssistLevel < 5
-        && now % parkAssistDisplayMod[parkAssistLevel] < parkAssistDisplayCompare[parkAssistLevel]
-    ) {
-        display->fillRect(
-            PA_BAR_MARGIN + PA_BAR_W * parkAssistSlot ,
-            SCREEN_HEIGHT - PA_BAR_H,
-            PA_BAR_W + PA_BAR_EXTRA_W,
-            PA_BAR_H,
-            SSD1306_WHITE
-        );
-    }
+    return {
+        static_cast<uint8_t>(region.x + spare / 2 + region.w / PA_SLOTS * slot),
+        static_cast<uint8_t>(region.y + region.h - PA_BAR_H),
+        static_cast<uint8_t>(region.w / PA_SLOTS + spare % 2),
+        PA_BAR_H
+    };
 }
 
 /**
- * Renders the Park Assist distance, assumes the display is already blank
- * Does not update display
+ * Marks the columns of a rectangle slot dirty
+ * @param slot the slot [0...4]
  */
-void GMParkAssist::renderDistance() const {
-    // max text size is realistically 9 - examples "255cm" or "12in" or "21ft 3in" or "20ft 10in"
-    char text[12];
+void GMParkAssist::markMarkerDirty(uint8_t const slot) const {
+    const Region marker = getMarker(slot);
+    flusher->markDirty(marker.x, marker.y, marker.w, marker.h);
+}
 
-    if (units == GMLAN_VAL_CLUSTER_UNITS_IMPERIAL) {
-        // convert cm to inches, then divide out feet
-        auto inches = static_cast<uint8_t>(lround(CM_PER_IN * parkAssistDistance));
-        const auto feet = inches / 12;
-        inches -= feet * 12;
+/**
+ * Updates the Park Assist rectangle
+ * Rectangle will be shown visible or invisible based on Clock::now()
+ * Only marks the rectangle zone dirty if the rectangle changed
+ * Also schedules the next blink edge
+ */
+void GMParkAssist::updateMarkerRectangle() {
+    const auto now = Clock::now();
+    bool visible = false;
+    markerDeadline = RENDERER_NO_DEADLINE;
 
-        // only show feet if there is at least 1 foot
-        if (feet > 0) {
-            snprintf(text, 11, "%dft %din", feet, inches);
-        } else {
-            snprintf(text, 11, "%din", inches);
+    if (parkAssistLevel > 0 && parkAssistLevel < 5) {
+        const uint16_t mod = pgm_read_word(&PA_BLINK_PERIOD[parkAssistLevel]);
+        const uint16_t compare = pgm_read_word(&PA_BLINK_VISIBLE[parkAssistLevel]);
+        const auto phase = now % mod;
+        visible = phase < compare;
+
+        // levels which blink change at the end of the visible part and at the end of the period
+        if (compare < mod) {
+            markerDeadline = makeDeadline(now + (visible ? compare - phase : mod - phase));
         }
-    } else {
-        snprintf(text, 11, "%dcm", parkAssistDistance);
     }
 
+    if (visible == markerVisible && (!visible || parkAssistSlot == markerSlot)) {
+        // nothing changed, so don't waste time sending the same page again
+        return;
+    }
+
+    // only the old and new rectangle columns can have changed
+    if (markerVisible) {
+        markMarkerDirty(markerSlot);
+    }
+
+    if (visible) {
+        markMarkerDirty(parkAssistSlot);
+    }
+
+    markerVisible = visible;
+    markerSlot = parkAssistSlot;
+}
+
+/**
+ * Draws the Park Assist distance and rectangle last shown by render()
+ * @param canvas the page being built
+ */
+void GMParkAssist::draw(PageCanvas& canvas) const {
     // distance text display
-    uint16_t width;
-    uint16_t height;
-    display->setTextSize(1);
-    display->setTextColor(SSD1306_WHITE);
-    display->setFont(&FreeSans9pt7b);
-    TextHelper::getTextBounds(display, text, &FreeSans9pt7b, &width, &height);
-    display->setCursor(static_cast<int16_t>(SCREEN_WIDTH - width) / 2, static_cast<int16_t>(height));
-    display->write(text);
+    TextLayout text;
+    TextTables::getDistance(static_cast<uint8_t>(distanceFilter.getShownValue()), units, text);
+    canvas.drawText(
+        text.font,
+        static_cast<int16_t>(region.x + (region.w - text.width) / 2),
+        static_cast<int16_t>(region.y + text.height),
+        text.text
+    );
+
+    if (markerVisible) {
+        const Region marker = getMarker(markerSlot);
+        canvas.fillRect(marker.x, marker.y, marker.w, marker.h);
+    }
+}
+
+/**
+ * Distance as displayed in the current units
+ * @return centimeters or inches
+ */
+uint8_t GMParkAssist::getDisplayedDistance() const {
+    return units == GMLAN_VAL_CLUSTER_UNITS_IMPERIAL
+        ? Units::centimetersToInches(parkAssistDistance)
+        : parkAssistDistance;
 }
 
 /**
  * Handles the Rear Park Assist "OFF" message
  */
 void GMParkAssist::processParkAssistDisableMessage() {
-    DEBUG(Serial.println(F("PA OFF")));
+    TELEMETRY(PARK_ASSIST_OFF);
 
     // blanking out all data will prevent future render
-    lastTimestamp = 0;
+    active = false;
     parkAssistDistance = 0;
     parkAssistLevel = 0;
     parkAssistSlot = 0;
     needsRender = false;
+    redrawPending = false;
+    distanceDeferred = false;
+
+    // the next ON message is drawn in full, whatever distance was last shown
+    distanceFilter.reset();
 }
 
 /**
@@ -95,21 +138,24 @@ void GMParkAssist::processParkAssistDisableMessage() {
  */
 void GMParkAssist::processParkAssistInfoMessage(const uint8_t buf[8]) {
     /*
-     * buf[1] is shortest real distance to nearest object, from 0x00 to 0xFF, in centimeters
-     * rendering function will multiply by 0.0328084 for inches if selected
+     * PARK_ASSIST_DISTANCE is shortest real distance to nearest object, from 0x00 to 0xFF, in centimeters
+     * rendering function will divide by 2.54 for inches if selected
      */
 
-    DEBUG(Serial.printf(F("PA ON, distance: %ucm\n"), buf[1]));
+    lastTimestamp = Clock::now();
+    active = true;
+    parkAssistDistance = GMLanSignals::raw<GMLanSignal::PARK_ASSIST_DISTANCE>(buf);
+    TELEMETRY(PARK_ASSIST_ON, parkAssistDistance);
 
-    lastTimestamp = millis() | 1; // never 0 because of bool evaluation elsewhere; value being 1 ms off is OK
-    parkAssistDistance = buf[1];
+    const uint8_t previousLevel = parkAssistLevel;
+    const uint8_t previousSlot = parkAssistSlot;
 
     /*
      * The park assist sensor controller takes 4 sensor streams and pushes them into 3 data streams for lef/mid/right
      * an obstruction can exist in one nibble, or two adjacent nibbles, creating five total combinations.  The goal is
      * to determine the position of the rectangle from five possible positions, and its blink rate.
      * It is OK to assume that in a multi-nibble scenario (like L+M) that the values will match.
-     * buf[2] and buf[3] nibbles are [M, R] and [0, L]
+     * buf[2] and buf[3] nibbles are [M, R] and [0, L], the PARK_ASSIST_MIDDLE/RIGHT/LEFT signals
      * for each nibble:
      *  0 = nothing seen
      *  1 = stop (red, solid image/beep)
@@ -119,9 +165,9 @@ void GMParkAssist::processParkAssistInfoMessage(const uint8_t buf[8]) {
      * Example: buf[2], buf[3] == 0b00100010 (0x22), 0b00000000 (0x00) means M+R at level 2 (close)
      */
 
-    const uint8_t slot_m = (buf[2] & 0xF0) >> 4;
-    const uint8_t slot_r = buf[2] & 0x0F;
-    const uint8_t slot_l = buf[3] & 0x0F;
+    const uint8_t slot_m = GMLanSignals::raw<GMLanSignal::PARK_ASSIST_MIDDLE>(buf);
+    const uint8_t slot_r = GMLanSignals::raw<GMLanSignal::PARK_ASSIST_RIGHT>(buf);
+    const uint8_t slot_l = GMLanSignals::raw<GMLanSignal::PARK_ASSIST_LEFT>(buf);
 
     if (slot_m) {
         // middle slot active, so obstruction is mid-left, mid, or mid-right
@@ -150,16 +196,32 @@ void GMParkAssist::processParkAssistInfoMessage(const uint8_t buf[8]) {
         parkAssistSlot = 2;
     }
 
-    // will force render of distance text on next call to render()
-    needsRender = true;
+    // the newest distance decides, a change held back earlier is dropped if the distance went back
+    switch (distanceFilter.check(parkAssistDistance, getDisplayedDistance(), DISTANCE_SIGNAL)) {
+        case SignalChange::NOW:
+            redrawPending = true;
+            distanceDeferred = false;
+            break;
+        case SignalChange::LATER:
+            distanceDeferred = true;
+            break;
+        case SignalChange::NONE:
+            distanceDeferred = false;
+            break;
+    }
+
+    // a moved rectangle or a new blink rate only needs the rectangle zone, repeated frames need nothing
+    if (redrawPending || parkAssistLevel != previousLevel || parkAssistSlot != previousSlot) {
+        needsRender = true;
+    }
 }
 
 /**
  * Create a GMParkAssist instance
- * @param display the OLED display from SSD1306 library
+ * @param flusher partial display updater
  * @param units the initial unit state
  */
-GMParkAssist::GMParkAssist(Adafruit_SSD1306* display, uint8_t const units) : Renderer(display, units) {}
+GMParkAssist::GMParkAssist(PageFlusher* flusher, uint8_t const units) : Renderer(flusher, units) {}
 
 /**
  * Processes the park assist message and sets state
@@ -167,7 +229,7 @@ GMParkAssist::GMParkAssist(Adafruit_SSD1306* display, uint8_t const units) : Ren
  * @param len the length of the buffer data
  * @param buf is the buffer data from GMLAN
  */
-void GMParkAssist::processMessage(uint32_t const arbId, uint8_t len, uint8_t buf[8]) {
+void GMParkAssist::processMessage(uint32_t const arbId, [[maybe_unused]] uint8_t const len, uint8_t buf[8]) {
     if (arbId != GMLAN_MSG_PARK_ASSIST) {
         // don't process irrelevant messages
         return;
@@ -175,9 +237,9 @@ void GMParkAssist::processMessage(uint32_t const arbId, uint8_t len, uint8_t buf
 
     /*
      * Right nibble of buf[0] tells whether Rear Park Assist is ON or OFF
-     * Left nibble may have unneeded data, so need to mask it out
+     * Left nibble may have unneeded data, PARK_ASSIST_STATE leaves it out
      */
-    const auto state = buf[0] & 0x0F;
+    const auto state = GMLanSignals::raw<GMLanSignal::PARK_ASSIST_STATE>(buf);
 
     if (state == GMLAN_VAL_PARK_ASSIST_OFF) {
         processParkAssistDisableMessage();
@@ -190,23 +252,46 @@ void GMParkAssist::processMessage(uint32_t const arbId, uint8_t len, uint8_t buf
     }
 
     // Don't recognize this message
-    DEBUG(Serial.printf(F("PA Unknown value %u\n"), state));
+    TELEMETRY(PARK_ASSIST_OTHER, static_cast<uint8_t>(state));
 }
 
 /**
- * Renders the current Park Assist display
+ * Shows the current Park Assist data
  * Should only be called if there is something to render
- * Updates the display
+ * Marks only the changed regions dirty, usually just the rectangle when blinking or moving
+ * The whole region is only redrawn when the displayed distance or the units changed
  */
 void GMParkAssist::render() {
-    if (needsRender) {
-        display->clearDisplay();
-        renderDistance();
-        needsRender = false;
+    if (redrawPending || (distanceDeferred && isDeadlineDue(distanceFilter.readyAt(DISTANCE_SIGNAL)))) {
+        markRegionDirty();
+        distanceFilter.shown(parkAssistDistance, getDisplayedDistance());
+        redrawPending = false;
+        distanceDeferred = false;
     }
 
-    renderMarkerRectangle();
-    display->display();
+    updateMarkerRectangle();
+    needsRender = false;
+}
+
+/**
+ * Forget what is in the region, so the next render() draws the distance text too
+ */
+void GMParkAssist::invalidate() {
+    Renderer::invalidate();
+    redrawPending = true;
+}
+
+/**
+ * Sets new cluster units, the distance text is redrawn in them
+ * @param newUnits the new unit data (GMLAN_VAL_CLUSTER_UNITS_*)
+ * @param visible whether the renderer can render, so the change must be drawn
+ */
+void GMParkAssist::setUnits(uint8_t const newUnits, bool const visible) {
+    Renderer::setUnits(newUnits, visible);
+
+    if (visible) {
+        redrawPending = true;
+    }
 }
 
 /**
@@ -216,11 +301,11 @@ void GMParkAssist::render() {
  */
 bool GMParkAssist::shouldRender() {
     // if lastTimestamp is too long ago, then disable it
-    if (lastTimestamp > 0 && millis() > lastTimestamp + PA_TIMEOUT) {
+    if (active && Clock::now() - lastTimestamp > PA_TIMEOUT) {
         processParkAssistDisableMessage();
     }
 
-    return needsRender || lastTimestamp > 0;
+    return needsRender || active;
 }
 
 /**
@@ -234,19 +319,37 @@ bool GMParkAssist::canRender() {
 }
 
 /**
- * Determines whether this module wants to process this GMLAN message
- * This module only processes Arb ID 0x1D4
- * @param arbId the arbitration ID to check
- * @return whether this module cares about this arbitration ID
+ * Determines when the display will next change without new data
+ * This is the next blink edge of the rectangle, a held back distance change, or the park assist timeout,
+ * whichever is first
+ * @return Clock::now() timestamp of the next change, or RENDERER_NO_DEADLINE
  */
-bool GMParkAssist::recognizesArbId(uint32_t const arbId) {
-    return arbId == GMLAN_MSG_PARK_ASSIST || arbId == GMLAN_MSG_CLUSTER_UNITS;
+uint32_t GMParkAssist::getNextDeadline() {
+    if (!active) {
+        return RENDERER_NO_DEADLINE;
+    }
+
+    uint32_t deadline = makeDeadline(lastTimestamp + PA_TIMEOUT + 1);
+
+    if (markerDeadline != RENDERER_NO_DEADLINE && static_cast<int32_t>(markerDeadline - deadline) < 0) {
+        deadline = markerDeadline;
+    }
+
+    if (distanceDeferred) {
+        const uint32_t ready = distanceFilter.readyAt(DISTANCE_SIGNAL);
+
+        if (static_cast<int32_t>(ready - deadline) < 0) {
+            deadline = ready;
+        }
+    }
+
+    return deadline;
 }
 
 /**
  * Returns the name of this renderer
  * @return the name as a string
  */
-const char* GMParkAssist::getName() const {
-    return "GMParkAssist";
+const __FlashStringHelper* GMParkAssist::getName() const {
+    return F("GMParkAssist");
 }
@@ -2,19 +2,16 @@
 #define GM_PARK_ASSIST_H
 
 #include <Arduino.h>
-#include <Adafruit_SSD1306.h>
+#include "GMLanSignals.h"
 #include "Renderer.h"
+#include "SignalFilter.h"
 
-// park assist marker measurements
+// park assist marker measurements, the slots split the width of the region
 #define PA_BAR_H 8
-#define PA_BAR_MARGIN_TOTAL (SCREEN_WIDTH % 5)
-#define PA_BAR_MARGIN (PA_BAR_MARGIN_TOTAL / 2)
-#define PA_BAR_W (SCREEN_WIDTH / 5)
-#define PA_BAR_EXTRA_W (PA_BAR_MARGIN_TOTAL % 2)
+#define PA_SLOTS 5
 
 // park assist config
 #define PA_TIMEOUT 10000UL // time out park assist mode after 10 seconds
-#define CM_PER_IN 0.393701 // for converting park assist distance to Imperial units
 
 class GMParkAssist final : public Renderer {
     /**
@@ -22,6 +19,11 @@ class GMParkAssist final : public Renderer {
      */
     uint32_t lastTimestamp = 0;
 
+    /**
+     * Whether a PA notification was received since the last "OFF" message or timeout, lastTimestamp is only set then
+     */
+    bool active = false;
+
     /**
      * rectangle rendering position
      * 0 for off or [1...5] for [left...right]
@@ -42,29 +44,61 @@ class GMParkAssist final : public Renderer {
     uint8_t parkAssistDistance = 0;
 
     /**
-     * Used by renderMarkerRectangle to determine blink rate for park assist
-     * Note only indexes 1 through 4 are used
+     * Distance on the display, to skip redrawing the text when it would not change
+     */
+    SignalFilter distanceFilter;
+
+    /**
+     * Whether the distance text must be updated on the next render(), which redraws the whole region
+     */
+    bool redrawPending = false;
+
+    /**
+     * Whether a distance change was held back by DISTANCE_SIGNAL.minIntervalMs, drawn at distanceFilter.readyAt()
+     */
+    bool distanceDeferred = false;
+
+    /**
+     * Whether the rectangle is currently shown
+     */
+    bool markerVisible = false;
+
+    /**
+     * Slot the rectangle is currently shown in, only meaningful if markerVisible
+     */
+    uint8_t markerSlot = 0;
+
+    /**
+     * Timestamp of the next blink edge, or RENDERER_NO_DEADLINE if the rectangle is solid or hidden
      */
-    uint32_t parkAssistDisplayMod[5] = {1U, 1U, 300U, 650U, 1000U};
+    uint32_t markerDeadline = RENDERER_NO_DEADLINE;
 
     /**
-     * Used by renderMarkerRectangle to determine blink rate for park assist
-     * Note only indexes 1 through 4 are used
+     * Rectangle of a slot, along the bottom of the region
+     * @param slot the slot [0...4]
+     * @return the rectangle
      */
-    uint32_t parkAssistDisplayCompare[5] = {1U, 1U, 150U, 325U, 500U};
+    [[nodiscard]] Region getMarker(uint8_t slot) const;
 
     /**
-     * Renders the Park Assist rectangle, blanking out the rectangle zone first
-     * Rectangle will be rendered visible or invisible based on millis()
-     * Does not update display
+     * Marks the columns of a rectangle slot dirty
+     * @param slot the slot [0...4]
      */
-    void renderMarkerRectangle() const;
+    void markMarkerDirty(uint8_t slot) const;
 
     /**
-     * Renders the Park Assist distance, assumes the display is already blank
-     * Does not update display
+     * Updates the Park Assist rectangle
+     * Rectangle will be shown visible or invisible based on Clock::now()
+     * Only marks the rectangle zone dirty if the rectangle changed
+     * Also schedules the next blink edge
      */
-    void renderDistance() const;
+    void updateMarkerRectangle();
+
+    /**
+     * Distance as displayed in the current units
+     * @return centimeters or inches
+     */
+    [[nodiscard]] uint8_t getDisplayedDistance() const;
 
     /**
      * Handles the Rear Park Assist "OFF" message
@@ -78,12 +112,24 @@ class GMParkAssist final : public Renderer {
     void processParkAssistInfoMessage(const uint8_t buf[8]);
 
 public:
+    /**
+     * ARB IDs this module processes, see ArbRegistry
+     * This module only processes the frame with the PARK_ASSIST_* signals, Arb ID 0x1D4
+     */
+    static constexpr uint32_t ARB_IDS[] = {GMLanSignals::arbIdOf(GMLanSignal::PARK_ASSIST_STATE)};
+
+    /**
+     * Redraw rules for the distance text, see SignalFilter
+     * Any change of the displayed distance is drawn straight away, the rectangle is never held back
+     */
+    static constexpr SignalSettings DISTANCE_SIGNAL = {0, 0};
+
     /**
      * Create a GMParkAssist instance
-     * @param display the OLED display from SSD1306 library
+     * @param flusher partial display updater
      * @param units the initial unit state
      */
-    GMParkAssist(Adafruit_SSD1306 *display, uint8_t units);
+    GMParkAssist(PageFlusher *flusher, uint8_t units);
 
     /**
      * Process GMLAN message
@@ -91,21 +137,40 @@ public:
      * @param len the length of the buffer data
      * @param buf buffer data from GMLAN
      */
-    void processMessage(uint32_t arbId, uint8_t len, uint8_t buf[8]) override;
+    void processMessage(uint32_t arbId, uint8_t len, uint8_t buf[8]);
 
     /**
-     * Renders the current Park Assist display
+     * Shows the current Park Assist data
      * Should only be called if there is something to render
-     * Updates the display
+     * Marks only the changed regions dirty, usually just the rectangle when blinking or moving
+     * The whole region is only redrawn when the displayed distance or the units changed
+     */
+    void render();
+
+    /**
+     * Draws the Park Assist distance and rectangle last shown by render()
+     * @param canvas the page being built
+     */
+    void draw(PageCanvas& canvas) const;
+
+    /**
+     * Forget what is in the region, so the next render() draws the distance text too
+     */
+    void invalidate();
+
+    /**
+     * Sets new cluster units, the distance text is redrawn in them
+     * @param newUnits the new unit data (GMLAN_VAL_CLUSTER_UNITS_*)
+     * @param visible whether the renderer can render, so the change must be drawn
      */
-    void render() override;
+    void setUnits(uint8_t newUnits, bool visible);
 
     /**
      * Determines whether there is new data to render
      * Rendering should happen if PA has not timed out, or if needsRender is true
      * @return whether rendering should occur
      */
-    bool shouldRender() override;
+    bool shouldRender();
 
     /**
      * Determines whether there is data which can be rendered
@@ -113,21 +178,21 @@ public:
      * all data is cleared out and there would be nothing to render anyway
      * @return whether rendering can occur
      */
-    bool canRender() override;
+    bool canRender();
 
     /**
-     * Determines whether this module wants to process this GMLAN message
-     * This module only processes Arb ID 0x1D4
-     * @param arbId the arbitration ID to check
-     * @return whether this module cares about this arbitration ID
+     * Determines when the display will next change without new data
+     * This is the next blink edge of the rectangle, a held back distance change, or the park assist timeout,
+     * whichever is first
+     * @return Clock::now() timestamp of the next change, or RENDERER_NO_DEADLINE
      */
-    bool recognizesArbId(uint32_t arbId) override;
+    uint32_t getNextDeadline();
 
     /**
      * Returns the name of this renderer
      * @return the name as a string
      */
-    [[nodiscard]] const char* getName() const override;
+    [[nodiscard]] const __FlashStringHelper* getName() const;
 };
 
 #endif //GM_PARK_ASSIST_H
@@ -1,109 +1,196 @@
 #include <Arduino.h>
-#include <math.h>
-#include <Adafruit_GFX.h>
-#include <Adafruit_SSD1306.h>
-#include <Fonts/FreeSans18pt7b.h>
 
-#include "Debug.h"
+#include "Flash.h"
+#include "Telemetry.h"
 #include "GMTemperature.h"
-#include "TextHelper.h"
+#include "TextTables.h"
+#include "Units.h"
 #include "OLED.h"
 #include "GMLan.h"
 
 /**
  * Create a GMTemperature instance
- * @param display the OLED display from SSD1306 library
+ * @param flusher partial display updater
  * @param units the initial unit state
  */
-GMTemperature::GMTemperature(Adafruit_SSD1306* display, uint8_t const units) : Renderer(display, units) {}
+GMTemperature::GMTemperature(PageFlusher* flusher, uint8_t const units) : Renderer(flusher, units) {}
 
 /**
  * Processes the exterior temperature sensor data
  * @param arbId the arbitration ID GMLAN_MSG_TEMPERATURE
  * @param length the length of the buffer data
  * @param buffer is the buffer data from GMLAN
- * @return
  */
-void GMTemperature::processMessage(uint32_t const arbId, uint8_t length, uint8_t buffer[8]) {
+void GMTemperature::processMessage(uint32_t const arbId, [[maybe_unused]] uint8_t const length, uint8_t buffer[8]) {
     if (arbId != GMLAN_MSG_TEMPERATURE) {
         // don't process irrelevant messages
         return;
     }
 
-    DEBUG(Serial.printf(F("Got temperature: 0x%02x\n"), buffer[1]));
-
     /**
-     * buffer[1] is hex representation of 2 * temperature in C with offset of 40 degrees
-     * math is done in rendering function (including Imperial units conversion)
+     * TEMPERATURE is 2 * temperature in C with offset of 40 degrees, see GMLAN_SIGNALS
+     * the raw value is kept, math is done in rendering function (including Imperial units conversion)
      */
 
-    if (temperature != buffer[1]) {
-        temperature = buffer[1];
+    temperature = GMLanSignals::raw<GMLanSignal::TEMPERATURE>(buffer);
+    restoredAge = 0;
+    TELEMETRY(TEMPERATURE, temperature);
+
+    // the newest value decides, a change held back earlier is dropped if the reading went back
+    switch (filter.check(temperature, getDisplayedTemperature(), TEMPERATURE_SIGNAL)) {
+        case SignalChange::NOW:
+            needsRender = true;
+            deferred = false;
+            break;
+        case SignalChange::LATER:
+            deferred = true;
+            break;
+        case SignalChange::NONE:
+            deferred = false;
+            break;
+    }
+
+    // live data replaces a stale restored temperature, even if it reads the same
+    if (staleShown) {
         needsRender = true;
+        deferred = false;
     }
 }
 
 /**
- * Renders the current Temperature display
+ * Show a temperature saved by an earlier power-up until live data arrives, see Flash::getTemperature()
+ * It is drawn like live data, with the stale marker if it is TEMPERATURE_STALE_AGE power-ups old
+ * @param raw the raw TEMPERATURE signal, 0 if there is none
+ * @param age power-ups since it was shown, at least 1
+ */
+void GMTemperature::restore(uint8_t const raw, uint8_t const age) {
+    if (raw == 0) {
+        return;
+    }
+
+    temperature = raw;
+    restoredAge = age;
+    needsRender = true;
+    TELEMETRY(TEMPERATURE_RESTORED, raw, age);
+}
+
+/**
+ * Temperature as displayed in the current units
+ * @return whole degrees
+ */
+int16_t GMTemperature::getDisplayedTemperature() const {
+    return units == GMLAN_VAL_CLUSTER_UNITS_IMPERIAL
+        ? Units::rawToFahrenheit(temperature)
+        : Units::rawToCelsius(temperature);
+}
+
+/**
+ * Shows the current Temperature
  * Should only be called if there is something to render
- * Updates the display
+ * Marks the whole region dirty
  */
 void GMTemperature::render() {
-    DEBUG(Serial.println(F("Render Temperature")));
-    display->clearDisplay();
-
-    // max text size is realistically 6 - examples "-40  F" or "190  F" or "-40  C" or "88  C"
-    char text[10];
-    auto convertedTemperature = temperature / 2 - 40;
-    auto unit = 'C';
-
-    if (units == GMLAN_VAL_CLUSTER_UNITS_IMPERIAL) {
-        // F = 1.8*C + 32
-        unit = 'F';
-        convertedTemperature = static_cast<uint8_t>(lround(1.8 * convertedTemperature)) + 32;
-    }
+    const auto convertedTemperature = getDisplayedTemperature();
+    TELEMETRY(TEMPERATURE_DRAW, convertedTemperature);
 
-    // extra space is to make room for degree symbol, which isn't available in font
-    snprintf(text, 9, "%d  %c", convertedTemperature, unit);
+    // text width changes with the value, so the whole region is redrawn
+    markRegionDirty();
+    filter.shown(temperature, convertedTemperature);
+    staleShown = restoredAge >= TEMPERATURE_STALE_AGE;
+    needsRender = false;
+    deferred = false;
 
+    // the next power-up starts from what is shown now, only changes are written
+    if (restoredAge == 0) {
+        Flash::saveTemperature(temperature);
+    }
+}
+
+/**
+ * Draws the temperature last shown by render(), centered in the region
+ * A region too small for the large text, such as a corner next to park assist, gets the compact text at its top
+ * @param canvas the page being built
+ */
+void GMTemperature::draw(PageCanvas& canvas) const {
     // temperature text/graphic display
-    uint16_t width;
-    uint16_t height;
-    TextHelper::getTextBounds(display, text, &FreeSans18pt7b, &width, &height);
-    display->setTextSize(1);
-    display->setTextColor(SSD1306_WHITE);
-    display->setFont(&FreeSans18pt7b);
+    TextLayout text;
+    TextTables::getTemperature(filter.getShownValue(), units, text);
+    const auto width = text.width;
+    const auto height = text.height;
+
+    if (width > region.w || height > region.h) {
+        drawCompact(canvas);
+        return;
+    }
 
     // x1 is left position of text
-    const auto x1 = static_cast<int16_t>((SCREEN_WIDTH - width) / 2);
+    const auto x1 = static_cast<int16_t>(region.x + (region.w - width) / 2);
     // x2 is 25px inside right of text, for degree symbol ('F' and 'C' are similar enough in width)
-    const auto x2 = static_cast<int16_t>((SCREEN_WIDTH + width) / 2 - 25);
+    const auto x2 = static_cast<int16_t>(region.x + (region.w + width) / 2 - 25);
     // y1 is bottom position of text
-    const auto y1 = static_cast<int16_t>((SCREEN_HEIGHT + height) / 2);
+    const auto y1 = static_cast<int16_t>(region.y + (region.h + height) / 2);
     // y2 is used for degree symbol center point
-    const auto y2 = static_cast<int16_t>((SCREEN_HEIGHT - height) / 2 + 5);
-
-    DEBUG(Serial.printf(F("Temperature text: \"%s\", x1=%d, x2=%d, y1=%d y2=%d\n"), text, x1, x2, y1, y2));
+    const auto y2 = static_cast<int16_t>(region.y + (region.h - height) / 2 + 5);
 
     // write text
-    display->setCursor(x1, y1);
-    display->write(text);
+    canvas.drawText(text.font, x1, y1, text.text);
 
     // write degree symbol
-    display->drawCircle(x2, y2, 3, SSD1306_WHITE);
-    display->drawCircle(x2, y2, 4, SSD1306_WHITE);
+    canvas.drawCircle(x2, y2, 3);
+    canvas.drawCircle(x2, y2, 4);
 
-    // show display text
-    display->display();
-    needsRender = false;
+    if (staleShown) {
+        // one row clear of the text, as far down as the region allows
+        const auto bottom = static_cast<int16_t>(region.y + region.h - 1);
+        drawStaleMarker(canvas, x1, y1 + 2 < bottom ? static_cast<int16_t>(y1 + 2) : bottom, width);
+    }
+}
+
+/**
+ * Draws the temperature last shown by render() in the built-in font, at the top of the region
+ * @param canvas the page being built
+ */
+void GMTemperature::drawCompact(PageCanvas& canvas) const {
+    TextLayout text;
+    TextTables::getCompactTemperature(filter.getShownValue(), units, text);
+
+    const auto x1 = static_cast<int16_t>(region.x + (region.w - text.width) / 2);
+    // the unit letter starts one advance before the end, the degree symbol is 2 columns into the space before it
+    const auto x2 = static_cast<int16_t>(x1 + text.width + 1 - 2 * TEXT_BUILT_IN_ADVANCE + 2);
+
+    // built-in font glyphs are placed by their top row
+    canvas.drawText(text.font, x1, region.y, text.text);
+    canvas.drawCircle(x2, static_cast<int16_t>(region.y + 1), 1);
+
+    if (staleShown) {
+        drawStaleMarker(canvas, x1, static_cast<int16_t>(region.y + TEXT_BUILT_IN_HEIGHT + 1), text.width);
+    }
+}
+
+/**
+ * Draws the stale marker, a dashed line under the text
+ * @param canvas the page being built
+ * @param x left position of the text
+ * @param y row of the line
+ * @param width width of the text
+ */
+void GMTemperature::drawStaleMarker(PageCanvas& canvas, int16_t const x, int16_t const y, uint8_t const width) {
+    // 2 columns on, 2 off, cut at the end of the text
+    for (int16_t dash = x; dash < x + width; dash += 4) {
+        canvas.fillRect(dash, y, dash + 1 < x + width ? 2 : 1, 1);
+    }
 }
 
 /**
  * Determines whether there is new data to render
- * Rendering should happen if the temperature changed
+ * Rendering should happen if the displayed temperature changed, see TEMPERATURE_SIGNAL
  * @return whether rendering should occur
  */
 bool GMTemperature::shouldRender() {
+    if (deferred && isDeadlineDue(filter.readyAt(TEMPERATURE_SIGNAL))) {
+        needsRender = true;
+    }
+
     return temperature > 0 && needsRender;
 }
 
@@ -115,20 +202,19 @@ bool GMTemperature::shouldRender() {
 bool GMTemperature::canRender() {
     return temperature > 0 || needsRender;
 }
+
 /**
- * Determines whether this module wants to process this GMLAN message
- * This module only processes Arb ID 0x212
- * @param arbId the arbitration ID to check
- * @return whether this module cares about this arbitration ID
+ * Determines when a held back temperature change may be drawn
+ * @return Clock::now() timestamp, or RENDERER_NO_DEADLINE if nothing is held back
  */
-bool GMTemperature::recognizesArbId(uint32_t const arbId) {
-    return arbId == GMLAN_MSG_TEMPERATURE;
+uint32_t GMTemperature::getNextDeadline() {
+    return deferred ? filter.readyAt(TEMPERATURE_SIGNAL) : RENDERER_NO_DEADLINE;
 }
 
 /**
  * Returns the name of this renderer
  * @return the name as a string
  */
-const char* GMTemperature::getName() const {
-    return "GMTemperature";
+const __FlashStringHelper* GMTemperature::getName() const {
+    return F("GMTemperature");
 }
@@ -2,8 +2,12 @@
 #define GM_TEMPERATURE_H
 
 #include <Arduino.h>
-#include <Adafruit_SSD1306.h>
+#include "GMLanSignals.h"
 #include "Renderer.h"
+#include "SignalFilter.h"
+
+// a restored temperature at least this many power-ups old is drawn with a stale marker, see Flash::getTemperatureAge()
+#define TEMPERATURE_STALE_AGE 2
 
 class GMTemperature final : public Renderer {
     /**
@@ -12,13 +16,66 @@ class GMTemperature final : public Renderer {
      */
     uint8_t temperature = 0;
 
+    /**
+     * Temperature on the display, to skip redraws which would show the same text
+     */
+    SignalFilter filter;
+
+    /**
+     * Whether a change was held back by TEMPERATURE_SIGNAL.minIntervalMs, drawn at filter.readyAt()
+     */
+    bool deferred = false;
+
+    /**
+     * Power-ups since the temperature restored from Flash was shown from live data, 0 once live data arrived
+     */
+    uint8_t restoredAge = 0;
+
+    /**
+     * Whether the temperature last shown by render() is marked stale
+     */
+    bool staleShown = false;
+
+    /**
+     * Temperature as displayed in the current units
+     * @return whole degrees
+     */
+    [[nodiscard]] int16_t getDisplayedTemperature() const;
+
+    /**
+     * Draws the temperature last shown by render() in the built-in font, at the top of the region
+     * @param canvas the page being built
+     */
+    void drawCompact(PageCanvas& canvas) const;
+
+    /**
+     * Draws the stale marker, a dashed line under the text
+     * @param canvas the page being built
+     * @param x left position of the text
+     * @param y row of the line
+     * @param width width of the text
+     */
+    static void drawStaleMarker(PageCanvas& canvas, int16_t x, int16_t y, uint8_t width);
+
 public:
+    /**
+     * ARB IDs this module processes, see ArbRegistry
+     * This module only processes the frame with the TEMPERATURE signal, Arb ID 0x212
+     */
+    static constexpr uint32_t ARB_IDS[] = {GMLanSignals::arbIdOf(GMLanSignal::TEMPERATURE)};
+
+    /**
+     * Redraw rules for the temperature, see SignalFilter
+     * Half a degree of hysteresis keeps a reading on a rounding boundary from flickering between two values
+     */
+    static constexpr SignalSettings TEMPERATURE_SIGNAL = {1, 0};
+
     /**
      * Create a GMTemperature instance
-     * @param display the OLED display from SSD1306 library
+     * @param flusher partial display updater
      * @param units the initial unit state
      */
-    GMTemperature(Adafruit_SSD1306 *display, uint8_t units);
+    GMTemperature(PageFlusher *flusher, uint8_t units);
 
     /**
      * Process GMLAN message
@@ -26,42 +83,53 @@ public:
      * @param length the length of the buffer data
      * @param buffer buffer data from GMLAN
      */
-    void processMessage(uint32_t arbId, uint8_t length, uint8_t buffer[8]) override;
+    void processMessage(uint32_t arbId, uint8_t length, uint8_t buffer[8]);
+
+    /**
+     * Show a temperature saved by an earlier power-up until live data arrives, see Flash::getTemperature()
+     * @param raw the raw TEMPERATURE signal, 0 if there is none
+     * @param age power-ups since it was shown, at least 1
+     */
+    void restore(uint8_t raw, uint8_t age);
 
     /**
-     * Renders the current Temperature display
+     * Shows the current Temperature
      * Should only be called if there is something to render
-     * Updates the display
+     * Marks the whole region dirty
+     */
+    void render();
+
+    /**
+     * Draws the temperature last shown by render(), centered in the region
+     * @param canvas the page being built
      */
-    void render() override;
+    void draw(PageCanvas& canvas) const;
 
     /**
      * Determines whether there is new data to render
-     * Rendering should happen if the temperature changed
+     * Rendering should happen if the displayed temperature changed, see TEMPERATURE_SIGNAL
      * @return whether rendering should occur
      */
-    bool shouldRender() override;
+    bool shouldRender();
 
     /**
      * Determines whether there is data which can be rendered
      * Rendering may happen if there is temperature data
      * @return whether rendering can occur
      */
-    bool canRender() override;
+    bool canRender();
 
     /**
-     * Determines whether this module wants to process this GMLAN message
-     * This module only processes Arb ID 0x212
-     * @param arbId the arbitration ID to check
-     * @return whether this module cares about this arbitration ID
+     * Determines when a held back temperature change may be drawn
+     * @return Clock::now() timestamp, or RENDERER_NO_DEADLINE if nothing is held back
      */
-    bool recognizesArbId(uint32_t arbId) override;
+    uint32_t getNextDeadline();
 
     /**
      * Returns the name of this renderer
      * @return the name as a string
      */
-    [[nodiscard]] const char* getName() const override;
+    [[nodiscard]] const __FlashStringHelper* getName() const;
 };
 
 
@@ -0,0 +1,99 @@
+#include "GlyphBlitter.h"
+#include "OLED.h"
+
+/**
+ * OR the part of one glyph on a page into that page, clipped to the display
+ * A glyph page whose top row is shift rows into a display page covers the bottom of that page and the top of the
+ * next, so a display page takes the glyph page starting on it shifted down, and the one above it shifted up
+ * @param row the page's columns
+ * @param rowPage page of the display they hold
+ * @param bitmap the font's PROGMEM glyph bitmaps
+ * @param glyph the glyph
+ * @param left column of the glyph's left edge
+ * @param top row of the glyph's top edge
+ */
+static void drawGlyph(
+    uint8_t* row,
+    uint8_t const rowPage,
+    const uint8_t* bitmap,
+    const PageGlyph& glyph,
+    int16_t const left,
+    int16_t const top
+) {
+    const int16_t firstColumn = left < 0 ? -left : 0;
+    const int16_t endColumn = left + glyph.width > SCREEN_WIDTH ? SCREEN_WIDTH - left : glyph.width;
+
+    if (firstColumn >= endColumn) {
+        return;
+    }
+
+    const auto columns = static_cast<uint8_t>(endColumn - firstColumn);
+    const auto shift = static_cast<uint8_t>(top & (OLED_PAGE_HEIGHT - 1));
+
+    // exact, so it rounds down for glyphs starting above the display as well
+    const auto upperPage = static_cast<int16_t>(rowPage - (top - shift) / OLED_PAGE_HEIGHT);
+
+    const uint8_t* const source = bitmap + glyph.offset + firstColumn;
+    uint8_t* const target = row + left + firstColumn;
+
+    if (upperPage >= 0 && upperPage < glyph.pages) {
+        const uint8_t* const upper = source + upperPage * glyph.width;
+
+        for (uint8_t column = 0; column < columns; column++) {
+            target[column] |= pgm_read_byte(upper + column) << shift;
+        }
+    }
+
+    if (shift > 0 && upperPage > 0 && upperPage <= glyph.pages) {
+        const uint8_t* const lower = source + (upperPage - 1) * glyph.width;
+
+        for (uint8_t column = 0; column < columns; column++) {
+            target[column] |= pgm_read_byte(lower + column) >> (OLED_PAGE_HEIGHT - shift);
+        }
+    }
+}
+
+/**
+ * Draw the part of some text on a page
+ * @param row the page's columns, SCREEN_WIDTH bytes
+ * @param page page of the display they hold
+ * @param font PROGMEM font
+ * @param x origin of the first glyph, as Adafruit_GFX::setCursor()
+ * @param baseline baseline of the text, as Adafruit_GFX::setCursor()
+ * @param text the text, characters missing from the font are skipped
+ */
+void GlyphBlitter::draw(
+    uint8_t* row,
+    uint8_t const page,
+    const PageFont* font,
+    int16_t x,
+    int16_t const baseline,
+    const char* text
+) {
+    PageFont fontData;
+    memcpy_P(&fontData, font, sizeof(fontData));
+
+    for (; *text != '\0'; text++) {
+        const char* found = strchr_P(fontData.chars, *text);
+
+        if (found == nullptr) {
+            continue;
+        }
+
+        PageGlyph glyph;
+        memcpy_P(&glyph, fontData.glyphs + (found - fontData.chars), sizeof(glyph));
+
+        if (glyph.width > 0) {
+            drawGlyph(
+                row,
+                page,
+                fontData.bitmap,
+                glyph,
+                static_cast<int16_t>(x + glyph.xOffset),
+                static_cast<int16_t>(baseline + glyph.yOffset)
+            );
+        }
+
+        x += glyph.xAdvance;
+    }
+}
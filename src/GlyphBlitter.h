@@ -0,0 +1,83 @@
+#ifndef GLYPH_BLITTER_H
+#define GLYPH_BLITTER_H
+
+#include <Arduino.h>
+
+/**
+ * A glyph repacked for SSD1306 pages, see PageFont
+ */
+struct PageGlyph {
+    /**
+     * First byte of the glyph in PageFont::bitmap
+     */
+    uint16_t offset;
+
+    /**
+     * Columns, each one byte per page
+     */
+    uint8_t width;
+
+    /**
+     * Pages, rows of 8 pixels, the glyph's top row is bit 0 of its first page
+     */
+    uint8_t pages;
+
+    /**
+     * Distance to the next glyph's origin, as in Adafruit GFX
+     */
+    uint8_t xAdvance;
+
+    /**
+     * Left column, from the origin, as in Adafruit GFX
+     */
+    int8_t xOffset;
+
+    /**
+     * Top row, from the baseline, as in Adafruit GFX
+     */
+    int8_t yOffset;
+};
+
+/**
+ * An Adafruit GFX font cut down to the characters the firmware draws, generated by scripts/generate_text_tables.py
+ * Glyph bitmaps are page-major column bytes like the display memory: every column of the first page, then of the next
+ * Everything, this struct included, is in PROGMEM
+ */
+struct PageFont {
+    /**
+     * Characters in the font, in glyph order, NUL terminated
+     */
+    const char* chars;
+
+    /**
+     * One glyph per character
+     */
+    const PageGlyph* glyphs;
+
+    /**
+     * Glyph bitmaps
+     */
+    const uint8_t* bitmap;
+};
+
+/**
+ * Draws text into a page of the display a byte at a time, see PageCanvas
+ * Adafruit_GFX::write() unpacks every glyph bit and sets pixels one by one, here each glyph byte is ORed into the
+ * page, split over two pages when the glyph's top row isn't on a page boundary
+ * Text is always white, drawn over what is there, the same pixels Adafruit_GFX::write() draws without text wrap
+ */
+class GlyphBlitter {
+public:
+    /**
+     * Draw the part of some text on a page
+     * @param row the page's columns, SCREEN_WIDTH bytes
+     * @param page page of the display they hold
+     * @param font PROGMEM font
+     * @param x origin of the first glyph, as Adafruit_GFX::setCursor()
+     * @param baseline baseline of the text, as Adafruit_GFX::setCursor()
+     * @param text the text, characters missing from the font are skipped
+     */
+    static void draw(uint8_t* row, uint8_t page, const PageFont* font, int16_t x, int16_t baseline, const char* text);
+};
+
+#endif //GLYPH_BLITTER_H
@@ -5,4 +5,45 @@
 #define SCREEN_WIDTH 128
 #define SCREEN_HEIGHT 32
 
+// SSD1306 memory is organized as horizontal pages of 8 pixel rows, each column of a page is one byte
+#define OLED_PAGE_HEIGHT 8
+#define OLED_PAGES (SCREEN_HEIGHT / OLED_PAGE_HEIGHT)
+
+// 1 to build each page just before it is sent, in a buffer of one page, instead of keeping a framebuffer
+#ifndef OLED_PAGE_MODE
+#define OLED_PAGE_MODE 0
+#endif
+
+// pages PageFlusher keeps in RAM
+#if OLED_PAGE_MODE == 1
+#define OLED_BUFFER_PAGES 1
+#else
+#define OLED_BUFFER_PAGES OLED_PAGES
+#endif
+
+// parameter of SSD1306_CHARGEPUMP, the charge pump must be off while the panel sleeps
+#define OLED_CHARGEPUMP_ON 0x14
+#define OLED_CHARGEPUMP_OFF 0x10
+
+// SSD1306 commands sent by PageFlusher, names as in Adafruit_SSD1306
+#define SSD1306_MEMORYMODE 0x20
+#define SSD1306_COLUMNADDR 0x21
+#define SSD1306_PAGEADDR 0x22
+#define SSD1306_DEACTIVATE_SCROLL 0x2E
+#define SSD1306_SETSTARTLINE 0x40
+#define SSD1306_SETCONTRAST 0x81
+#define SSD1306_CHARGEPUMP 0x8D
+#define SSD1306_SEGREMAP 0xA0
+#define SSD1306_DISPLAYALLON_RESUME 0xA4
+#define SSD1306_NORMALDISPLAY 0xA6
+#define SSD1306_SETMULTIPLEX 0xA8
+#define SSD1306_DISPLAYOFF 0xAE
+#define SSD1306_DISPLAYON 0xAF
+#define SSD1306_COMSCANDEC 0xC8
+#define SSD1306_SETDISPLAYOFFSET 0xD3
+#define SSD1306_SETDISPLAYCLOCKDIV 0xD5
+#define SSD1306_SETPRECHARGE 0xD9
+#define SSD1306_SETCOMPINS 0xDA
+#define SSD1306_SETVCOMDETECT 0xDB
+
 #endif //CAMARO_DISPLAY_OLED_H
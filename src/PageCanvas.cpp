@@ -0,0 +1,131 @@
+#include "PageCanvas.h"
+#include "OLED.h"
+
+/**
+ * Create a canvas
+ * @param row the page's columns, SCREEN_WIDTH bytes
+ * @param page page of the display they hold
+ */
+PageCanvas::PageCanvas(uint8_t* row, uint8_t const page) : row(row), page(page) {}
+
+/**
+ * Determine whether any of a band of rows is on this page, to skip building what would be clipped anyway
+ * @param y top row
+ * @param h height
+ * @return whether it overlaps
+ */
+bool PageCanvas::overlaps(int16_t const y, int16_t const h) const {
+    const int16_t top = page * OLED_PAGE_HEIGHT;
+    return h > 0 && y < top + OLED_PAGE_HEIGHT && y + h > top;
+}
+
+/**
+ * Set a pixel
+ * @param x column
+ * @param y row
+ */
+void PageCanvas::drawPixel(int16_t const x, int16_t const y) {
+    if (x < 0 || x >= SCREEN_WIDTH || y < 0 || y / OLED_PAGE_HEIGHT != page) {
+        return;
+    }
+
+    row[x] |= _BV(y & (OLED_PAGE_HEIGHT - 1));
+}
+
+/**
+ * Fill a rectangle
+ * Every column of the page takes the same mask of rows, so this is one OR per column
+ * @param x left position
+ * @param y top position
+ * @param w width
+ * @param h height
+ */
+void PageCanvas::fillRect(int16_t x, int16_t y, int16_t w, int16_t h) {
+    const int16_t top = page * OLED_PAGE_HEIGHT;
+
+    // clip to the page
+    if (x < 0) {
+        w += x;
+        x = 0;
+    }
+
+    if (y < top) {
+        h -= top - y;
+        y = top;
+    }
+
+    if (x + w > SCREEN_WIDTH) {
+        w = static_cast<int16_t>(SCREEN_WIDTH - x);
+    }
+
+    if (y + h > top + OLED_PAGE_HEIGHT) {
+        h = static_cast<int16_t>(top + OLED_PAGE_HEIGHT - y);
+    }
+
+    if (w <= 0 || h <= 0) {
+        return;
+    }
+
+    // h rows from bit y - top
+    const auto mask = static_cast<uint8_t>((0xFF >> (OLED_PAGE_HEIGHT - h)) << (y - top));
+
+    for (uint8_t* column = row + x; column < row + x + w; column++) {
+        *column |= mask;
+    }
+}
+
+/**
+ * Draw a circle outline, the same pixels as Adafruit_GFX::drawCircle()
+ * Bresenham's midpoint algorithm, one octant is computed and mirrored into the other seven
+ * @param x0 center column
+ * @param y0 center row
+ * @param r radius
+ */
+void PageCanvas::drawCircle(int16_t const x0, int16_t const y0, int16_t const r) {
+    if (!overlaps(static_cast<int16_t>(y0 - r), static_cast<int16_t>(2 * r + 1))) {
+        return;
+    }
+
+    int16_t f = static_cast<int16_t>(1 - r);
+    int16_t ddFx = 1;
+    int16_t ddFy = static_cast<int16_t>(-2 * r);
+    int16_t x = 0;
+    int16_t y = r;
+
+    drawPixel(x0, static_cast<int16_t>(y0 + r));
+    drawPixel(x0, static_cast<int16_t>(y0 - r));
+    drawPixel(static_cast<int16_t>(x0 + r), y0);
+    drawPixel(static_cast<int16_t>(x0 - r), y0);
+
+    while (x < y) {
+        if (f >= 0) {
+            y--;
+            ddFy += 2;
+            f += ddFy;
+        }
+
+        x++;
+        ddFx += 2;
+        f += ddFx;
+
+        drawPixel(static_cast<int16_t>(x0 + x), static_cast<int16_t>(y0 + y));
+        drawPixel(static_cast<int16_t>(x0 - x), static_cast<int16_t>(y0 + y));
+        drawPixel(static_cast<int16_t>(x0 + x), static_cast<int16_t>(y0 - y));
+        drawPixel(static_cast<int16_t>(x0 - x), static_cast<int16_t>(y0 - y));
+        drawPixel(static_cast<int16_t>(x0 + y), static_cast<int16_t>(y0 + x));
+        drawPixel(static_cast<int16_t>(x0 - y), static_cast<int16_t>(y0 + x));
+        drawPixel(static_cast<int16_t>(x0 + y), static_cast<int16_t>(y0 - x));
+        drawPixel(static_cast<int16_t>(x0 - y), static_cast<int16_t>(y0 - x));
+    }
+}
+
+/**
+ * Draw text, see GlyphBlitter
+ * @param font PROGMEM font
+ * @param x origin of the first glyph, as Adafruit_GFX::setCursor()
+ * @param baseline baseline of the text, as Adafruit_GFX::setCursor()
+ * @param text the text
+ */
+void PageCanvas::drawText(const PageFont* font, int16_t const x, int16_t const baseline, const char* text) {
+    GlyphBlitter::draw(row, page, font, x, baseline, text);
+}
@@ -0,0 +1,123 @@
+#ifndef PAGE_CANVAS_H
+#define PAGE_CANVAS_H
+
+#include <Arduino.h>
+#include "GlyphBlitter.h"
+
+/**
+ * One page of the display, 8 rows across the whole width, one byte per column as the SSD1306 stores it
+ * Renderers draw their whole frame in display coordinates, anything outside the page is clipped, so the same calls
+ * build the frame one page at a time, see PageFlusher
+ * Everything is drawn white over what is there, the page starts out black
+ */
+class PageCanvas {
+    /**
+     * The page's columns, SCREEN_WIDTH bytes
+     */
+    uint8_t* row;
+
+    /**
+     * Page of the display this is
+     */
+    uint8_t page;
+
+public:
+    /**
+     * Create a canvas
+     * @param row the page's columns, SCREEN_WIDTH bytes
+     * @param page page of the display they hold
+     */
+    PageCanvas(uint8_t* row, uint8_t page);
+
+    /**
+     * Determine whether any of a band of rows is on this page, to skip building what would be clipped anyway
+     * @param y top row
+     * @param h height
+     * @return whether it overlaps
+     */
+    [[nodiscard]] bool overlaps(int16_t y, int16_t h) const;
+
+    /**
+     * Set a pixel
+     * @param x column
+     * @param y row
+     */
+    void drawPixel(int16_t x, int16_t y);
+
+    /**
+     * Fill a rectangle
+     * @param x left position
+     * @param y top position
+     * @param w width
+     * @param h height
+     */
+    void fillRect(int16_t x, int16_t y, int16_t w, int16_t h);
+
+    /**
+     * Draw a circle outline, the same pixels as Adafruit_GFX::drawCircle()
+     * @param x0 center column
+     * @param y0 center row
+     * @param r radius
+     */
+    void drawCircle(int16_t x0, int16_t y0, int16_t r);
+
+    /**
+     * Draw text, see GlyphBlitter
+     * @param font PROGMEM font
+     * @param x origin of the first glyph, as Adafruit_GFX::setCursor()
+     * @param baseline baseline of the text, as Adafruit_GFX::setCursor()
+     * @param text the text
+     */
+    void drawText(const PageFont* font, int16_t x, int16_t baseline, const char* text);
+};
+
+/**
+ * A frame which can be drawn again on request, handed to PageFlusher::flush() to build each page it sends
+ * Wraps anything with draw(PageCanvas&) const, such as a renderer, without it being virtual
+ */
+class FrameSource {
+    /**
+     * Calls draw() on owner, as its own type
+     */
+    void (*drawFrame)(const void* owner, PageCanvas& canvas) = nullptr;
+
+    /**
+     * What draws the frame
+     */
+    const void* owner = nullptr;
+
+public:
+    /**
+     * A blank frame
+     */
+    FrameSource() = default;
+
+    /**
+     * The frame drawn by source.draw(), source must outlive the FrameSource
+     * @tparam Source type with draw(PageCanvas&) const
+     * @param source what draws the frame
+     * @return the frame
+     */
+    template<typename Source>
+    static FrameSource of(const Source& source) {
+        FrameSource frame;
+        frame.owner = &source;
+        frame.drawFrame = [](const void* owner, PageCanvas& canvas) {
+            static_cast<const Source*>(owner)->draw(canvas);
+        };
+
+        return frame;
+    }
+
+    /**
+     * Draw the part of the frame on a page
+     * @param canvas the page
+     */
+    void draw(PageCanvas& canvas) const {
+        if (drawFrame != nullptr) {
+            drawFrame(owner, canvas);
+        }
+    }
+};
+
+#endif //PAGE_CANVAS_H
@@ -0,0 +1,399 @@
+#include <util/atomic.h>
+
+#include "PageFlusher.h"
+#include "SpiBus.h"
+
+#ifdef HAL_NATIVE
+#include <cstdio>
+#include <cstdlib>
+#endif
+
+// flusher with a transfer in flight, for the interrupt
+static PageFlusher* volatile activeFlusher = nullptr;
+
+/*
+ * Panel setup for a 128x32 module running from its charge pump, as sent by Adafruit_SSD1306::begin()
+ * The charge pump and the panel itself are turned on by the first flush(), see WAKE_COMMANDS
+ */
+static const uint8_t INIT_COMMANDS[] PROGMEM = {
+    SSD1306_DISPLAYOFF,
+    SSD1306_SETDISPLAYCLOCKDIV, 0x80,
+    SSD1306_SETMULTIPLEX, SCREEN_HEIGHT - 1,
+    SSD1306_SETDISPLAYOFFSET, 0x00,
+    SSD1306_SETSTARTLINE | 0x00,
+    SSD1306_MEMORYMODE, 0x00, // horizontal addressing, see beginPage()
+    SSD1306_SEGREMAP | 0x01,
+    SSD1306_COMSCANDEC,
+    SSD1306_SETCOMPINS, 0x02,
+    SSD1306_SETCONTRAST, 0x8F,
+    SSD1306_SETPRECHARGE, 0xF1,
+    SSD1306_SETVCOMDETECT, 0x40,
+    SSD1306_DISPLAYALLON_RESUME,
+    SSD1306_NORMALDISPLAY,
+    SSD1306_DEACTIVATE_SCROLL,
+};
+
+// GDDRAM kept its contents while asleep, so the panel shows the last frame until the next transfer replaces it
+static const uint8_t WAKE_COMMANDS[] PROGMEM = {SSD1306_CHARGEPUMP, OLED_CHARGEPUMP_ON, SSD1306_DISPLAYON};
+
+// with the panel off and its charge pump stopped, the SSD1306 draws only a few microamps
+static const uint8_t SLEEP_COMMANDS[] PROGMEM = {SSD1306_DISPLAYOFF, SSD1306_CHARGEPUMP, OLED_CHARGEPUMP_OFF};
+
+#ifdef HAL_NATIVE
+/**
+ * Compare the panel with the whole frame drawn from scratch
+ * Unless a renderer changed something without marking it dirty, what partial updates left on the panel is the same
+ * @param source the frame
+ */
+static void checkPanel(const FrameSource& source) {
+    uint8_t row[SCREEN_WIDTH];
+
+    for (uint8_t page = 0; page < OLED_PAGES; page++) {
+        memset(row, 0, sizeof(row));
+        PageCanvas canvas(row, page);
+        source.draw(canvas);
+
+        if (memcmp(row, FakeOled::ram[page], sizeof(row)) != 0) {
+            fprintf(stderr, "page %u on the panel differs from the frame, a change was not marked dirty\n", page);
+            abort();
+        }
+    }
+}
+#endif
+
+/**
+ * SPI finished clocking out a byte
+ */
+ISR(SPI_STC_vect) {
+    if (activeFlusher != nullptr) {
+        activeFlusher->transferNext();
+    }
+}
+
+/**
+ * Create a PageFlusher
+ * @param dcPin OLED data/command pin
+ * @param csPin OLED chip select pin
+ * @param spiBaud OLED SPI clock speed
+ */
+PageFlusher::PageFlusher(uint8_t const dcPin, uint8_t const csPin, uint32_t const spiBaud)
+    : spiSettings(spiBaud, MSBFIRST, SPI_MODE0), dcPin(dcPin), csPin(csPin) {
+    clearDirty();
+}
+
+/**
+ * Reset and set up the panel, it stays off until the first flush()
+ * Display RAM is not cleared, mark everything dirty and flush a blank frame before showing anything
+ * @param rstPin OLED reset pin
+ */
+void PageFlusher::begin(uint8_t const rstPin) {
+    SPI.begin();
+    pinMode(dcPin, OUTPUT);
+    pinMode(csPin, OUTPUT);
+    digitalWrite(csPin, HIGH);
+
+    // reset pulse, as long as Adafruit_SSD1306::begin() holds it
+    pinMode(rstPin, OUTPUT);
+    digitalWrite(rstPin, HIGH);
+    delay(1);
+    digitalWrite(rstPin, LOW);
+    delay(10);
+    digitalWrite(rstPin, HIGH);
+
+    sendCommands(INIT_COMMANDS, sizeof(INIT_COMMANDS));
+    displayOn = false;
+}
+
+/**
+ * Send commands to the panel, waits for a transfer still in flight first
+ * Runs in the foreground, the CAN controller is kept off the bus by SpiBus::beginTransaction()
+ * @param commands PROGMEM commands and their parameters
+ * @param length number of bytes
+ */
+void PageFlusher::sendCommands(const uint8_t* commands, uint8_t const length) {
+    wait();
+    SpiBus::beginTransaction(spiSettings);
+    digitalWrite(dcPin, LOW);
+    digitalWrite(csPin, LOW);
+
+    for (uint8_t i = 0; i < length; i++) {
+        SPI.transfer(pgm_read_byte(commands + i));
+    }
+
+    digitalWrite(csPin, HIGH);
+    SpiBus::endTransaction();
+}
+
+/**
+ * Build a page from a frame, cleared first, as drawing only ever sets pixels
+ * @param source the frame
+ * @param page the page
+ */
+void PageFlusher::drawPage(const FrameSource& source, uint8_t const page) {
+    uint8_t* const row = pageRow(page);
+    memset(row, 0, SCREEN_WIDTH);
+    PageCanvas canvas(row, page);
+    source.draw(canvas);
+}
+
+/**
+ * Marks every page as clean
+ */
+void PageFlusher::clearDirty() {
+    // a page is dirty when start <= end, so a start past the last column marks it clean
+    for (uint8_t page = 0; page < OLED_PAGES; page++) {
+        dirtyStart[page] = SCREEN_WIDTH;
+        dirtyEnd[page] = 0;
+    }
+}
+
+/**
+ * Mark a region of the display as changed
+ * Region is clipped to the screen
+ * @param x left position
+ * @param y top position
+ * @param w width
+ * @param h height
+ */
+void PageFlusher::markDirty(int16_t x, int16_t y, int16_t w, int16_t h) {
+    // clip region to screen
+    if (x < 0) {
+        w += x;
+        x = 0;
+    }
+
+    if (y < 0) {
+        h += y;
+        y = 0;
+    }
+
+    if (x + w > SCREEN_WIDTH) {
+        w = static_cast<int16_t>(SCREEN_WIDTH - x);
+    }
+
+    if (y + h > SCREEN_HEIGHT) {
+        h = static_cast<int16_t>(SCREEN_HEIGHT - y);
+    }
+
+    if (w <= 0 || h <= 0) {
+        return;
+    }
+
+    const auto start = static_cast<uint8_t>(x);
+    const auto end = static_cast<uint8_t>(x + w - 1);
+    const auto lastPage = static_cast<uint8_t>((y + h - 1) / OLED_PAGE_HEIGHT);
+
+    for (auto page = static_cast<uint8_t>(y / OLED_PAGE_HEIGHT); page <= lastPage; page++) {
+        if (start < dirtyStart[page]) {
+            dirtyStart[page] = start;
+        }
+
+        if (end > dirtyEnd[page]) {
+            dirtyEnd[page] = end;
+        }
+    }
+}
+
+/**
+ * Mark the whole display as changed
+ */
+void PageFlusher::markAllDirty() {
+    for (uint8_t page = 0; page < OLED_PAGES; page++) {
+        dirtyStart[page] = 0;
+        dirtyEnd[page] = SCREEN_WIDTH - 1;
+    }
+}
+
+/**
+ * Determine whether any part of the display has changed since the last flush
+ * @return whether there is anything to flush
+ */
+bool PageFlusher::isDirty() const {
+    for (uint8_t page = 0; page < OLED_PAGES; page++) {
+        if (dirtyStart[page] <= dirtyEnd[page]) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+/**
+ * Set up sending the first dirty page at or after a page
+ * The SSD1306 is set to horizontal addressing mode by begin(), so setting a one-page address window makes the data wrap within that window only
+ * @param first the page to start looking from
+ * @return false if no page from there on is dirty
+ */
+bool PageFlusher::beginPage(uint8_t const first) {
+    for (page = first; page < OLED_PAGES; page++) {
+        if (dirtyStart[page] <= dirtyEnd[page]) {
+            pageCommand[0] = SSD1306_PAGEADDR;
+            pageCommand[1] = page;
+            pageCommand[2] = page;
+            pageCommand[3] = SSD1306_COLUMNADDR;
+            pageCommand[4] = dirtyStart[page];
+            pageCommand[5] = dirtyEnd[page];
+            commandIndex = 0;
+            column = dirtyStart[page];
+            return true;
+        }
+    }
+
+    return false;
+}
+
+/**
+ * Start the SPI transaction for the page set up by beginPage()
+ * Only call with interrupts disabled
+ */
+void PageFlusher::startPage() {
+    SpiBus::configure(spiSettings);
+    SPCR |= _BV(SPIE);
+    digitalWrite(dcPin, LOW);
+    digitalWrite(csPin, LOW);
+    transferNext();
+}
+
+/**
+ * Send the next byte of the transfer
+ * Each page is one transaction, its address window commands with D/C low, then its dirty columns with D/C high
+ * Between pages the bus is released, so the CAN controller can be serviced
+ * Called by the SPI transfer complete interrupt, only call with interrupts disabled
+ */
+void PageFlusher::transferNext() {
+    // state is advanced before writing SPDR, the interrupt for that byte must see the next step
+
+    if (commandIndex < PAGE_FLUSHER_COMMAND_BYTES) {
+        const uint8_t command = pageCommand[commandIndex];
+        commandIndex++;
+        SPDR = command;
+        return;
+    }
+
+    if (commandIndex == PAGE_FLUSHER_COMMAND_BYTES) {
+        // last command byte is out, the rest of the page is data
+        digitalWrite(dcPin, HIGH);
+        commandIndex++;
+    }
+
+    if (column <= dirtyEnd[page]) {
+        const uint8_t data = pageRow(page)[column];
+        column++;
+        SPDR = data;
+        return;
+    }
+
+    // page sent, end its transaction
+    dirtyStart[page] = SCREEN_WIDTH;
+    dirtyEnd[page] = 0;
+    digitalWrite(csPin, HIGH);
+    SPCR &= ~_BV(SPIE);
+    SpiBus::yield();
+
+#if OLED_PAGE_MODE == 0
+    if (beginPage(page + 1)) {
+        startPage();
+        return;
+    }
+#endif
+
+    // all sent
+    activeFlusher = nullptr;
+    transferring = false;
+    SpiBus::endBackground();
+}
+
+/**
+ * Start sending the page set up by beginPage(), the interrupt sends the rest
+ */
+void PageFlusher::sendPage() {
+    SpiBus::beginBackground();
+    transferring = true;
+
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+        activeFlusher = this;
+        startPage();
+    }
+}
+
+/**
+ * Draw all dirty regions of a frame and start sending them, each page is marked clean once it is sent
+ * Waits for a transfer still in flight first, and turns the panel back on if it sleeps
+ * The CAN controller shares the bus, see SpiBus, received frames wait in the controller for at most one page
+ * With OLED_PAGE_MODE, only returns once everything is sent
+ * @param source the whole frame, only the dirty pages are drawn
+ */
+void PageFlusher::flush(const FrameSource& source) {
+    wait();
+
+    if (!beginPage(0)) {
+        return;
+    }
+
+    if (!displayOn) {
+        sendCommands(WAKE_COMMANDS, sizeof(WAKE_COMMANDS));
+        displayOn = true;
+    }
+
+#if OLED_PAGE_MODE == 1
+    // the buffer holds one page, the next can only be built once it is sent
+    do {
+        drawPage(source, page);
+        sendPage();
+        wait();
+    } while (beginPage(page + 1));
+#else
+    for (uint8_t dirty = page; dirty < OLED_PAGES; dirty++) {
+        if (dirtyStart[dirty] <= dirtyEnd[dirty]) {
+            drawPage(source, dirty);
+        }
+    }
+
+    sendPage();
+#endif
+
+#ifdef HAL_NATIVE
+    // the interrupt runs at once on the host, so the panel is up to date already
+    checkPanel(source);
+#endif
+}
+
+/**
+ * Put the panel to sleep, it stays asleep until the next flush() which sends anything
+ * Waits for a transfer still in flight first
+ */
+void PageFlusher::sleepDisplay() {
+    wait();
+
+    if (!displayOn) {
+        return;
+    }
+
+    sendCommands(SLEEP_COMMANDS, sizeof(SLEEP_COMMANDS));
+    displayOn = false;
+}
+
+/**
+ * Determine whether the panel is on
+ * @return false if the panel sleeps
+ */
+bool PageFlusher::isDisplayOn() const {
+    return displayOn;
+}
+
+/**
+ * Determine whether a transfer is in flight
+ * @return whether the buffer is being sent
+ */
+bool PageFlusher::isBusy() const {
+    return transferring;
+}
+
+/**
+ * Wait until the transfer in flight, if any, is finished
+ */
+void PageFlusher::wait() const {
+    while (transferring) {
+        // the interrupt does the work
+    }
+}
@@ -0,0 +1,209 @@
+#ifndef PAGE_FLUSHER_H
+#define PAGE_FLUSHER_H
+
+#include <Arduino.h>
+#include <SPI.h>
+#include "OLED.h"
+#include "PageCanvas.h"
+
+// bytes of the address window commands sent before each page
+#define PAGE_FLUSHER_COMMAND_BYTES 6
+
+/**
+ * Driver for the SSD1306, sends only what changed
+ * Renderers mark the regions they changed, and flush() draws the dirty pages from a FrameSource, then only sends
+ * the dirty column span of each dirty page, instead of the whole frame like Adafruit_SSD1306::display()
+ *
+ * With a framebuffer, the transfer runs in the background, one byte per SPI transfer complete interrupt,
+ * one SPI transaction per page, while isBusy(), the framebuffer is being read, so nothing may mark it dirty
+ * With OLED_PAGE_MODE, there is only a buffer for one page, so flush() builds and sends one page after the other,
+ * waiting for each, this saves the SCREEN_WIDTH * (OLED_PAGES - 1) bytes of the framebuffer
+ */
+class PageFlusher {
+    /**
+     * Pages built by flush(), the framebuffer, or with OLED_PAGE_MODE the page being sent
+     */
+    uint8_t buffer[SCREEN_WIDTH * OLED_BUFFER_PAGES];
+
+    /**
+     * SPI settings for the OLED
+     */
+    SPISettings spiSettings;
+
+    /**
+     * OLED data/command pin
+     */
+    uint8_t dcPin;
+
+    /**
+     * OLED chip select pin
+     */
+    uint8_t csPin;
+
+    /**
+     * First dirty column of each page
+     * A page is clean when its first dirty column is after its last dirty column
+     */
+    uint8_t dirtyStart[OLED_PAGES];
+
+    /**
+     * Last dirty column of each page
+     */
+    uint8_t dirtyEnd[OLED_PAGES];
+
+    /**
+     * Whether the panel is on, begin() leaves it off until the first flush()
+     */
+    bool displayOn = false;
+
+    /**
+     * Whether a transfer is in flight, cleared by the interrupt once the last byte is out
+     */
+    volatile bool transferring = false;
+
+    /**
+     * Page being sent
+     */
+    uint8_t page = 0;
+
+    /**
+     * Next byte of pageCommand to send, past the end once data is being sent
+     */
+    uint8_t commandIndex = 0;
+
+    /**
+     * Next column of the page to send
+     */
+    uint8_t column = 0;
+
+    /**
+     * Address window commands for the page being sent
+     */
+    uint8_t pageCommand[PAGE_FLUSHER_COMMAND_BYTES] = {};
+
+    /**
+     * Marks every page as clean
+     */
+    void clearDirty();
+
+    /**
+     * Columns of a page in the buffer
+     * @param page the page
+     * @return SCREEN_WIDTH bytes
+     */
+    uint8_t* pageRow(uint8_t const page) {
+#if OLED_PAGE_MODE == 1
+        static_cast<void>(page); // every page is built in the same place
+        return buffer;
+#else
+        return buffer + page * SCREEN_WIDTH;
+#endif
+    }
+
+    /**
+     * Send commands to the panel, waits for a transfer still in flight first
+     * @param commands PROGMEM commands and their parameters
+     * @param length number of bytes
+     */
+    void sendCommands(const uint8_t* commands, uint8_t length);
+
+    /**
+     * Build a page from a frame
+     * @param source the frame
+     * @param page the page
+     */
+    void drawPage(const FrameSource& source, uint8_t page);
+
+    /**
+     * Start sending the page set up by beginPage(), the interrupt sends the rest
+     */
+    void sendPage();
+
+    /**
+     * Set up sending the first dirty page at or after a page
+     * @param first the page to start looking from
+     * @return false if no page from there on is dirty
+     */
+    bool beginPage(uint8_t first);
+
+    /**
+     * Start the SPI transaction for the page set up by beginPage()
+     * Only call with interrupts disabled
+     */
+    void startPage();
+
+public:
+    /**
+     * Create a PageFlusher
+     * @param dcPin OLED data/command pin
+     * @param csPin OLED chip select pin
+     * @param spiBaud OLED SPI clock speed
+     */
+    PageFlusher(uint8_t dcPin, uint8_t csPin, uint32_t spiBaud);
+
+    /**
+     * Reset and set up the panel, it stays off until the first flush()
+     * @param rstPin OLED reset pin
+     */
+    void begin(uint8_t rstPin);
+
+    /**
+     * Mark a region of the display as changed
+     * Region is clipped to the screen
+     * @param x left position
+     * @param y top position
+     * @param w width
+     * @param h height
+     */
+    void markDirty(int16_t x, int16_t y, int16_t w, int16_t h);
+
+    /**
+     * Mark the whole display as changed
+     */
+    void markAllDirty();
+
+    /**
+     * Determine whether any part of the display has changed since the last flush
+     * @return whether there is anything to flush
+     */
+    [[nodiscard]] bool isDirty() const;
+
+    /**
+     * Draw all dirty regions of a frame and start sending them, each page is marked clean once it is sent
+     * Waits for a transfer still in flight first, and turns the panel back on if it sleeps
+     * With OLED_PAGE_MODE, only returns once everything is sent
+     * @param source the whole frame, only the dirty pages are drawn
+     */
+    void flush(const FrameSource& source);
+
+    /**
+     * Put the panel to sleep, it stays asleep until the next flush() which sends anything
+     * Waits for a transfer still in flight first
+     */
+    void sleepDisplay();
+
+    /**
+     * Determine whether the panel is on
+     * @return false if the panel sleeps
+     */
+    [[nodiscard]] bool isDisplayOn() const;
+
+    /**
+     * Determine whether a transfer is in flight
+     * @return whether the buffer is being sent
+     */
+    [[nodiscard]] bool isBusy() const;
+
+    /**
+     * Wait until the transfer in flight, if any, is finished
+     */
+    void wait() const;
+
+    /**
+     * Send the next byte of the transfer
+     * Called by the SPI transfer complete interrupt, only call with interrupts disabled
+     */
+    void transferNext();
+};
+
+#endif //PAGE_FLUSHER_H
@@ -0,0 +1,146 @@
+#include <Arduino.h>
+
+#include "Pipeline.h"
+#include "GMLan.h"
+#include "Flash.h"
+#include "Telemetry.h"
+#include "BusMonitor.h"
+#include "OLED.h"
+#include "Clock.h"
+
+/**
+ * Newest frame of each ARB ID, between the receive ring and processCanFrame()
+ */
+static FrameCoalescer<GMLanRegistry> coalescer;
+
+/**
+ * Clock::now() timestamp of the first frame with anything on it, only set once firstFrameShown
+ */
+static uint32_t firstFrameAt = 0;
+static bool firstFrameShown = false;
+
+// regions the layouts are made of
+static constexpr Region NOWHERE = {0, 0, 0, 0};
+static constexpr Region FULL_SCREEN = {0, 0, SCREEN_WIDTH, SCREEN_HEIGHT};
+static constexpr Region BESIDE_SIDE_COLUMN = {0, 0, SCREEN_WIDTH - LAYOUT_SIDE_COLUMN_W, SCREEN_HEIGHT};
+static constexpr Region SIDE_COLUMN = {SCREEN_WIDTH - LAYOUT_SIDE_COLUMN_W, 0, LAYOUT_SIDE_COLUMN_W, SCREEN_HEIGHT};
+
+/*
+ * Regions of a layout in GMLanRenderers order: park assist, diagnostics, temperature
+ * Builds without the diagnostics page leave its region out
+ */
+#if DO_DEBUG == 1
+#define GMLAN_LAYOUT(parkAssist, diagnostics, temperature) {{parkAssist, diagnostics, temperature}}
+#else
+#define GMLAN_LAYOUT(parkAssist, diagnostics, temperature) {{parkAssist, temperature}}
+#endif
+
+/*
+ * Layouts of GMLanRenderers
+ * The first layout whose renderers can all render is shown
+ */
+const GMLanRenderers::Layout GMLAN_LAYOUTS[] PROGMEM = {
+    // reversing, the outside temperature stays in a column on the right
+    GMLAN_LAYOUT(BESIDE_SIDE_COLUMN, NOWHERE, SIDE_COLUMN),
+    // reversing, before there is any temperature
+    GMLAN_LAYOUT(FULL_SCREEN, NOWHERE, NOWHERE),
+#if DO_DEBUG == 1
+    // diagnostics page, turned on from the debug console
+    GMLAN_LAYOUT(NOWHERE, FULL_SCREEN, NOWHERE),
+#endif
+    // outside temperature
+    GMLAN_LAYOUT(NOWHERE, NOWHERE, FULL_SCREEN),
+};
+
+const uint8_t GMLAN_LAYOUT_COUNT = sizeof(GMLAN_LAYOUTS) / sizeof(GMLAN_LAYOUTS[0]);
+
+/**
+ * Hand a received CAN frame to every consumer registered for its ARB ID
+ * @param frame
+ * @param renderers
+ */
+void processCanFrame(CanFrame& frame, GMLanRenderers& renderers) {
+    auto const arbId = GMLAN_ARB(frame.canId);
+    auto const consumers = GMLanRegistry::consumersOf(arbId);
+    TELEMETRY(CAN_FRAME, arbId, consumers);
+
+    if (consumers & _BV(CLUSTER_UNITS_CONSUMER)) {
+        const uint8_t units = GMLanSignals::raw<GMLanSignal::CLUSTER_UNITS>(frame.buf);
+        TELEMETRY(CLUSTER_UNITS, units);
+        Flash::saveUnits(units);
+        renderers.setUnits(units);
+    }
+
+    renderers.processMessage(consumers >> FIRST_RENDERER_CONSUMER, arbId, frame.len, frame.buf);
+}
+
+/**
+ * Process the CANBUS frames received since the last call
+ * Frames are read from the CAN controller by CanReceiver's interrupt, this only consumes them
+ * At most one ring's worth is taken per call, so a constant stream can't starve rendering
+ * Only the newest frame of each ARB ID is processed, older ones could never be shown
+ * @param renderers
+ */
+void readCanBus(GMLanRenderers& renderers) {
+    CanReceiver::poll();
+
+    CanFrame frame;
+
+    for (uint8_t i = 0; i < CanReceiver::capacity() && CanReceiver::pop(frame); i++) {
+        BusMonitor::countFrame(GMLanRegistry::indexOf(GMLAN_ARB(frame.canId)));
+        coalescer.add(frame);
+    }
+
+    coalescer.dispatch([&renderers](CanFrame& latest) {
+        processCanFrame(latest, renderers);
+    });
+}
+
+/**
+ * Number of received frames which were superseded by a newer frame of the same ARB ID before being processed
+ * @return the count
+ */
+uint16_t getStaleFrames() {
+    return coalescer.getSuperseded();
+}
+
+/**
+ * Reset the stale frame counter
+ */
+void clearStaleFrames() {
+    coalescer.clearCounters();
+}
+
+/**
+ * Render data to display
+ * The first frame with anything on it is timed, see getFirstFrameAt()
+ * Only the regions the renderers marked dirty are sent to the display, see RendererPipeline::render()
+ * @param flusher
+ * @param renderers
+ */
+void renderDisplay(PageFlusher* flusher, GMLanRenderers& renderers) {
+    renderers.render(flusher);
+
+    // time to first pixel, the frame is on its way to the panel, which takes one transfer more
+    if (!firstFrameShown && renderers.getLayout() != RENDERER_PIPELINE_NONE) {
+        firstFrameAt = Clock::now();
+        firstFrameShown = true;
+        TELEMETRY(FIRST_FRAME, firstFrameAt);
+    }
+}
+
+/**
+ * Determine whether a frame with anything on it was shown yet
+ * @return whether getFirstFrameAt() is set
+ */
+bool isFirstFrameShown() {
+    return firstFrameShown;
+}
+
+/**
+ * When the first frame with anything on it was shown
+ * @return Clock::now() timestamp, only meaningful once isFirstFrameShown()
+ */
+uint32_t getFirstFrameAt() {
+    return firstFrameAt;
+}
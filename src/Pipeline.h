@@ -0,0 +1,95 @@
+#ifndef PIPELINE_H
+#define PIPELINE_H
+
+#include <Arduino.h>
+
+#include "ArbRegistry.h"
+#include "CanReceiver.h"
+#include "FrameCoalescer.h"
+#include "PageFlusher.h"
+#include "RendererPipeline.h"
+#include "GMLanRenderers.h"
+#include "GMLanSignals.h"
+#include "GMParkAssist.h"
+#include "GMTemperature.h"
+
+#if DO_DEBUG == 1
+#include "BusDiagnostics.h"
+#endif
+
+/**
+ * Cluster units are not a renderer, readCanBus() applies them to every renderer
+ */
+struct ClusterUnits {
+    /**
+     * ARB IDs for cluster units, see ArbRegistry
+     */
+    static constexpr uint32_t ARB_IDS[] = {GMLanSignals::arbIdOf(GMLanSignal::CLUSTER_UNITS)};
+};
+
+/*
+ * Every consumer of GMLAN data, ClusterUnits followed by the renderers in GMLanRenderers
+ * This generates both the CAN controller masks/filters and the ARB ID dispatch
+ */
+using GMLanRegistry = GMLanRenderers::Registry<ClusterUnits>;
+static_assert(GMLanSignals::receivedBy<GMLanRegistry>(), "a signal in GMLAN_SIGNALS has no consumer");
+constexpr uint8_t CLUSTER_UNITS_CONSUMER = 0;
+constexpr uint8_t FIRST_RENDERER_CONSUMER = 1;
+
+// width of the column the temperature keeps on the right while park assist is shown
+#define LAYOUT_SIDE_COLUMN_W 32
+
+/**
+ * Layouts of GMLanRenderers, in priority order, see RendererPipeline
+ */
+extern const GMLanRenderers::Layout GMLAN_LAYOUTS[] PROGMEM;
+
+/**
+ * Number of GMLAN_LAYOUTS
+ */
+extern const uint8_t GMLAN_LAYOUT_COUNT;
+
+/**
+ * Hand a received CAN frame to every consumer registered for its ARB ID
+ * @param frame
+ * @param renderers
+ */
+void processCanFrame(CanFrame& frame, GMLanRenderers& renderers);
+
+/**
+ * Process the CANBUS frames received since the last call
+ * @param renderers
+ */
+void readCanBus(GMLanRenderers& renderers);
+
+/**
+ * Number of received frames which were superseded by a newer frame of the same ARB ID before being processed
+ * @return the count
+ */
+uint16_t getStaleFrames();
+
+/**
+ * Reset the stale frame counter
+ */
+void clearStaleFrames();
+
+/**
+ * Render data to display
+ * @param flusher
+ * @param renderers
+ */
+void renderDisplay(PageFlusher* flusher, GMLanRenderers& renderers);
+
+/**
+ * Determine whether a frame with anything on it was shown yet
+ * @return whether getFirstFrameAt() is set
+ */
+bool isFirstFrameShown();
+
+/**
+ * When the first frame with anything on it was shown
+ * @return Clock::now() timestamp, only meaningful once isFirstFrameShown()
+ */
+uint32_t getFirstFrameAt();
+
+#endif //PIPELINE_H
@@ -0,0 +1,135 @@
+#include <avr/sleep.h>
+#include <avr/power.h>
+
+#include "Power.h"
+#include "CanReceiver.h"
+#include "Deadline.h"
+#include "Watchdog.h"
+
+static uint32_t statsStart = 0;
+static uint32_t asleepUs = 0;
+static uint16_t wakes = 0;
+static uint16_t maxWakeUs = 0;
+
+/**
+ * Determine whether the main loop has work, or the deadline passed
+ * @param deadline Clock::now() timestamp, or RENDERER_NO_DEADLINE
+ * @return whether to stay awake
+ */
+static bool hasWork(uint32_t const deadline) {
+#if DO_DEBUG == 1
+    if (Serial.available()) {
+        return true;
+    }
+#endif
+
+    return CanReceiver::available() || CanReceiver::isPending() || isDeadlineDue(deadline);
+}
+
+/**
+ * Switch off the peripherals the firmware never uses, and select idle sleep
+ * Timer 0 is kept for millis(), SPI for the CAN controller and OLED, and the USART for the debug console
+ */
+void Power::begin() {
+    ADCSRA &= ~_BV(ADEN); // the ADC must be disabled before it is powered down
+    power_adc_disable();
+    power_twi_disable();
+    power_timer1_disable();
+    power_timer2_disable();
+
+#if DO_DEBUG != 1
+    power_usart0_disable();
+#endif
+
+    set_sleep_mode(SLEEP_MODE_IDLE);
+    clearStats();
+}
+
+/**
+ * Sleep until there is work for the main loop, or a deadline passes
+ * Interrupts are disabled between checking for work and sleeping, the instruction after sei always runs before
+ * any interrupt, so an interrupt can't slip in between and leave the MCU asleep with work waiting
+ * The hardware WDT is fed on every wake, the loop may sleep for longer than its timeout
+ * @param deadline Clock::now() timestamp to wake by, or RENDERER_NO_DEADLINE
+ */
+void Power::idle(uint32_t const deadline) {
+    bool slept = false;
+    uint32_t wokeAt = 0;
+
+    while (true) {
+        Watchdog::feedIdle();
+        noInterrupts();
+
+        if (hasWork(deadline)) {
+            interrupts();
+            break;
+        }
+
+        const uint32_t sleptAt = micros();
+        sleep_enable();
+        interrupts();
+        sleep_cpu();
+        sleep_disable();
+
+        wokeAt = micros();
+        asleepUs += wokeAt - sleptAt;
+        slept = true;
+    }
+
+    if (!slept || isDeadlineDue(deadline)) {
+        return;
+    }
+
+    // woken by an event, not a deadline
+    const uint32_t wakeUs = micros() - wokeAt;
+    wakes++;
+
+    if (wakeUs > maxWakeUs) {
+        maxWakeUs = wakeUs > UINT16_MAX ? UINT16_MAX : static_cast<uint16_t>(wakeUs);
+    }
+}
+
+/**
+ * Sleep and wake statistics since the last clearStats()
+ * micros() wraps after about 71 minutes, so statistics are only meaningful over shorter periods
+ * @return the statistics
+ */
+PowerStats Power::getStats() {
+    return {static_cast<uint32_t>(micros() - statsStart), asleepUs, wakes, maxWakeUs};
+}
+
+/**
+ * Share of the time spent asleep
+ * @param stats statistics from getStats()
+ * @return percentage, 0 to 100
+ */
+uint8_t Power::asleepPercent(const PowerStats& stats) {
+    // in milliseconds, so the product fits in 32 bits
+    const uint32_t totalMs = stats.totalUs / 1000;
+
+    if (totalMs == 0) {
+        return 0;
+    }
+
+    return static_cast<uint8_t>(stats.asleepUs / 1000 * 100 / totalMs);
+}
+
+/**
+ * Estimate the MCU's average supply current from the time it spent asleep
+ * @param stats statistics from getStats()
+ * @return microamps
+ */
+uint32_t Power::estimateMicroamps(const PowerStats& stats) {
+    const uint8_t asleep = asleepPercent(stats);
+    return (POWER_IDLE_UA * asleep + POWER_ACTIVE_UA * (100 - asleep)) / 100;
+}
+
+/**
+ * Start new statistics
+ */
+void Power::clearStats() {
+    statsStart = micros();
+    asleepUs = 0;
+    wakes = 0;
+    maxWakeUs = 0;
+}
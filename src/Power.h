@@ -0,0 +1,84 @@
+#ifndef POWER_H
+#define POWER_H
+
+#include <Arduino.h>
+
+/*
+ * Typical ATmega328P supply current at 16 MHz and 5 V, from the datasheet's typical characteristics
+ * Only used to estimate the average, measure the board to calibrate
+ */
+#define POWER_ACTIVE_UA 9000UL
+#define POWER_IDLE_UA 2500UL
+
+/**
+ * Sleep and wake statistics since the last Power::clearStats()
+ */
+struct PowerStats {
+    /**
+     * Microseconds covered by these statistics
+     */
+    uint32_t totalUs;
+
+    /**
+     * Microseconds spent asleep
+     */
+    uint32_t asleepUs;
+
+    /**
+     * Number of times sleep was ended by something other than a timer tick
+     */
+    uint16_t wakes;
+
+    /**
+     * Longest time from such a wake to idle() returning to the main loop
+     */
+    uint16_t maxWakeUs;
+};
+
+/**
+ * Low-power idle for the main loop
+ * The MCU sleeps in idle mode, so timer 0 (millis), SPI, USART and pin-change interrupts keep running and wake it,
+ * waking from idle takes no oscillator start-up time
+ * Timer 0 wakes the MCU every millisecond, idle() goes back to sleep until there is work, or the deadline passes
+ */
+class Power {
+public:
+    /**
+     * Switch off the peripherals the firmware never uses, and select idle sleep
+     */
+    static void begin();
+
+    /**
+     * Sleep until there is work for the main loop, or a deadline passes
+     * Work is a received CAN frame, a CAN frame waiting in the controller, or debug console input
+     * @param deadline Clock::now() timestamp to wake by, or RENDERER_NO_DEADLINE
+     */
+    static void idle(uint32_t deadline);
+
+    /**
+     * Sleep and wake statistics since the last clearStats()
+     * @return the statistics
+     */
+    [[nodiscard]] static PowerStats getStats();
+
+    /**
+     * Share of the time spent asleep
+     * @param stats statistics from getStats()
+     * @return percentage, 0 to 100
+     */
+    [[nodiscard]] static uint8_t asleepPercent(const PowerStats& stats);
+
+    /**
+     * Estimate the MCU's average supply current from the time it spent asleep
+     * @param stats statistics from getStats()
+     * @return microamps
+     */
+    [[nodiscard]] static uint32_t estimateMicroamps(const PowerStats& stats);
+
+    /**
+     * Start new statistics
+     */
+    static void clearStats();
+};
+
+#endif //POWER_H
@@ -0,0 +1,42 @@
+#ifndef REGION_H
+#define REGION_H
+
+#include <Arduino.h>
+
+/**
+ * A rectangle of the display, each renderer draws only inside the one its layout gives it, see RendererPipeline
+ */
+struct Region {
+    uint8_t x;
+    uint8_t y;
+    uint8_t w;
+    uint8_t h;
+
+    /**
+     * Determine whether the region has no pixels, a layout gives an empty region to every renderer it leaves out
+     * @return whether it is empty
+     */
+    [[nodiscard]] constexpr bool isEmpty() const {
+        return w == 0 || h == 0;
+    }
+
+    /**
+     * Determine whether two regions cover the same pixels
+     * @param other the other region
+     * @return whether they are the same
+     */
+    [[nodiscard]] constexpr bool operator==(const Region& other) const {
+        return x == other.x && y == other.y && w == other.w && h == other.h;
+    }
+
+    /**
+     * Determine whether two regions differ
+     * @param other the other region
+     * @return whether they are different
+     */
+    [[nodiscard]] constexpr bool operator!=(const Region& other) const {
+        return !(*this == other);
+    }
+};
+
+#endif //REGION_H
@@ -2,20 +2,69 @@
 
 /**
  * Create a Renderer
- * @param display OLED display
+ * @param flusher partial display updater
  * @param units the initial unit state
  */
-Renderer::Renderer(Adafruit_SSD1306* display, uint8_t const units): units(units), display(display) {}
+Renderer::Renderer(PageFlusher* flusher, uint8_t const units): units(units), flusher(flusher) {}
 
 /**
  * Sets new cluster units
  * @param newUnits the new unit data (GMLAN_VAL_CLUSTER_UNITS_*)
+ * @param visible whether the renderer can render, so the change must be drawn
  */
-void Renderer::setUnits(const uint8_t newUnits) {
+void Renderer::setUnits(const uint8_t newUnits, const bool visible) {
     this->units = newUnits;
 
-    if (canRender()) {
+    if (visible) {
         needsRender = true;
     }
 }
 
+/**
+ * Determine when the rendered output will next change without new data, such as a blink or a timeout
+ * By default, output only changes when new data arrives
+ * @return Clock::now() timestamp of the next change, or RENDERER_NO_DEADLINE
+ */
+uint32_t Renderer::getNextDeadline() {
+    return RENDERER_NO_DEADLINE;
+}
+
+/**
+ * Forget what is on the display, so the next render() draws everything
+ * Called when this renderer is placed in a region, which held something else
+ */
+void Renderer::invalidate() {
+    needsRender = true;
+}
+
+/**
+ * Move the renderer to another part of the display
+ * Nothing is drawn until the next render(), so call invalidate() too
+ * @param newRegion where to draw from now on
+ */
+void Renderer::place(const Region& newRegion) {
+    region = newRegion;
+}
+
+/**
+ * Returns the part of the display this renderer draws in
+ * @return the region
+ */
+const Region& Renderer::getRegion() const {
+    return region;
+}
+
+/**
+ * Mark the whole region dirty, for changes which move everything in it
+ */
+void Renderer::markRegionDirty() const {
+    flusher->markDirty(region.x, region.y, region.w, region.h);
+}
+
+/**
+ * Determine whether new data arrived which has not been rendered yet
+ * @return whether a render is pending
+ */
+bool Renderer::isRenderPending() const {
+    return needsRender;
+}
@@ -2,9 +2,27 @@
 #define RENDERER_H
 
 #include <Arduino.h>
-#include <Adafruit_SSD1306.h>
 #include "GMLan.h"
+#include "OLED.h"
+#include "PageCanvas.h"
+#include "PageFlusher.h"
+#include "Region.h"
+#include "Deadline.h"
 
+/**
+ * Base for modules which process GMLAN data and render it
+ * Each subclass must also declare static constexpr uint32_t ARB_IDS[] with the ARB IDs it processes,
+ * see ArbRegistry, processMessage() is only called for those
+ * A renderer which shows no GMLAN data, such as BusDiagnostics, leaves out ARB_IDS
+ *
+ * Drawing is split in two, render() decides what the display shows and marks what changed, draw() draws all of it
+ * draw() may be called several times per render(), once for each page sent, see PageFlusher
+ * Both stay inside region, which the layout chosen by RendererPipeline sets, and lay out their content to its size
+ *
+ * Nothing here is virtual, RendererPipeline calls each subclass directly
+ * Subclasses must provide processMessage(), render(), draw(), shouldRender(), canRender() and getName() as documented
+ * below, and may replace getNextDeadline(), invalidate() and setUnits()
+ */
 class Renderer {
 protected:
     /**
@@ -18,18 +36,26 @@ protected:
     uint8_t units = GMLAN_VAL_CLUSTER_UNITS_METRIC;
 
     /**
-     * OLED display
+     * Partial display updater, regions of the display which changed must be marked dirty here
      */
-    Adafruit_SSD1306 *display;
-public:
-    virtual ~Renderer() = default;
+    PageFlusher *flusher;
+
+    /**
+     * Part of the display this renderer draws in, set by RendererPipeline from its layouts
+     */
+    Region region = {0, 0, SCREEN_WIDTH, SCREEN_HEIGHT};
 
+    /**
+     * Mark the whole region dirty, for changes which move everything in it
+     */
+    void markRegionDirty() const;
+public:
     /**
      * Create a Renderer
-     * @param display OLED display
+     * @param flusher partial display updater
      * @param units the initial unit state
      */
-    Renderer(Adafruit_SSD1306 *display, uint8_t units);
+    Renderer(PageFlusher *flusher, uint8_t units);
 
     /**
      * Process a GMLAN message
@@ -37,46 +63,78 @@ public:
      * @param len the length of the buffer data
      * @param buf the buffer data
      */
-    virtual void processMessage(uint32_t arbId, uint8_t len, uint8_t buf[8]);
+    void processMessage(uint32_t arbId, uint8_t len, uint8_t buf[8]) = delete;
+
+    /**
+     * Updates what the display shows to the newest data
+     * Changed regions are marked dirty, caller is responsible for flushing them with this renderer's draw()
+     */
+    void render() = delete;
 
     /**
-     * Renders data to the display
+     * Draws everything the display shows, as of the last render(), anything outside the canvas is clipped
+     * @param canvas the page being built
      */
-    virtual void render();
+    void draw(PageCanvas& canvas) const = delete;
 
     /**
      * Determine whether there is an update which should be shown on the display now
      * Should return true if there is new data, or if this module needs to make sure its data is shown
      * @return whether the module should render
      */
-    virtual bool shouldRender();
+    bool shouldRender() = delete;
 
     /**
      * Determine whether there is data which could be shown on the display
      * Should return true if there is any low-priority data
      * @return whether the module can render
      */
-    virtual bool canRender();
+    bool canRender() = delete;
 
     /**
-     * Determine whether this module recognizes the Arbitration ID
-     * If true, it is assumed processMessage() will accept this message type
-     * @param arbId the Arbitration ID
-     * @return whether processMessage() will handle this Arbitration ID
+     * Determine when the rendered output will next change without new data, such as a blink or a timeout
+     * Only meaningful after render() was called
+     * @return Clock::now() timestamp of the next change, or RENDERER_NO_DEADLINE
+     */
+    uint32_t getNextDeadline();
+
+    /**
+     * Determine whether new data arrived which has not been rendered yet
+     * @return whether a render is pending
+     */
+    [[nodiscard]] bool isRenderPending() const;
+
+    /**
+     * Forget what is on the display, so the next render() draws everything
+     * Called when this renderer is placed in a region, which held something else
+     */
+    void invalidate();
+
+    /**
+     * Move the renderer to another part of the display
+     * Nothing is drawn until the next render(), so call invalidate() too
+     * @param newRegion where to draw from now on
+     */
+    void place(const Region& newRegion);
+
+    /**
+     * Returns the part of the display this renderer draws in
+     * @return the region
      */
-    virtual bool recognizesArbId(uint32_t arbId);
+    [[nodiscard]] const Region& getRegion() const;
 
     /**
      * Returns the name of this renderer
      * @return the name as a string
      */
-    [[nodiscard]] virtual const char* getName() const;
+    [[nodiscard]] const __FlashStringHelper* getName() const = delete;
 
     /**
      * Sets new cluster units
      * @param newUnits the new unit data (GMLAN_VAL_CLUSTER_UNITS_*)
+     * @param visible whether the renderer can render, so the change must be drawn
      */
-    void setUnits(uint8_t newUnits);
+    void setUnits(uint8_t newUnits, bool visible);
 };
 
 #endif //RENDERER_H
@@ -0,0 +1,424 @@
+#ifndef RENDERER_PIPELINE_H
+#define RENDERER_PIPELINE_H
+
+#include <Arduino.h>
+
+#include "ArbRegistry.h"
+#include "PageFlusher.h"
+#include "Region.h"
+#include "Renderer.h"
+#include "Telemetry.h"
+
+// RendererPipeline::getLayout() when nothing is on the display
+#define RENDERER_PIPELINE_NONE 0xFF
+
+/**
+ * Where each renderer of a RendererPipeline is drawn, for one combination of renderers
+ * A renderer with an empty region is left out, the others must not overlap
+ * @tparam Size number of renderers
+ */
+template<uint8_t Size>
+struct ScreenLayout {
+    /**
+     * Region of each renderer, in pipeline order
+     */
+    Region regions[Size];
+};
+
+/**
+ * Copy a region out of a PROGMEM layout
+ * @param region the region
+ * @return the copy
+ */
+inline Region readRegion(const Region* region) {
+    Region copy;
+    memcpy_P(&copy, region, sizeof(copy));
+    return copy;
+}
+
+/**
+ * Determine the earlier of two render deadlines
+ * @param a Clock::now() timestamp, or RENDERER_NO_DEADLINE
+ * @param b Clock::now() timestamp, or RENDERER_NO_DEADLINE
+ * @return whichever comes first, RENDERER_NO_DEADLINE only if both are
+ */
+inline uint32_t earlierDeadline(uint32_t const a, uint32_t const b) {
+    if (a == RENDERER_NO_DEADLINE) {
+        return b;
+    }
+
+    // subtracting keeps this correct when the clock overflows
+    return b != RENDERER_NO_DEADLINE && static_cast<int32_t>(b - a) < 0 ? b : a;
+}
+
+/**
+ * One link of RendererPipeline, holds the renderer at Index and the links after it
+ * Every call is made on the concrete renderer type, so the compiler can inline the whole chain
+ * @tparam Index position of the renderer, in priority order
+ * @tparam Renderers renderer types from Index onwards
+ */
+template<uint8_t Index, typename... Renderers>
+class RendererChain;
+
+/**
+ * End of the chain, nothing left to try
+ * @tparam Index one past the last renderer
+ */
+template<uint8_t Index>
+class RendererChain<Index> {
+public:
+    void setUnits(uint8_t) {}
+
+    void processMessage(uint8_t, uint32_t, uint8_t, uint8_t*) {}
+
+    bool canRender(const Region*) {
+        return true;
+    }
+
+    void place(PageFlusher*, const Region*, uint8_t&) {}
+
+    void render(uint8_t) {}
+
+    void draw(PageCanvas&, uint8_t) const {}
+
+    uint32_t getNextDeadline(uint8_t) {
+        return RENDERER_NO_DEADLINE;
+    }
+
+    template<typename Fn>
+    void forEach(Fn) {}
+};
+
+/**
+ * Renderer at Index, followed by the rest of the chain
+ * @tparam Index position of the renderer, in priority order
+ * @tparam First renderer type at Index
+ * @tparam Rest renderer types after Index
+ */
+template<uint8_t Index, typename First, typename... Rest>
+class RendererChain<Index, First, Rest...> {
+    First* renderer;
+    RendererChain<Index + 1, Rest...> rest;
+
+public:
+    /**
+     * Create a chain link
+     * @param first renderer at Index
+     * @param others renderers after Index
+     */
+    explicit RendererChain(First* first, Rest*... others) : renderer(first), rest(others...) {}
+
+    /**
+     * Sets new cluster units on every renderer
+     * @param units the new unit data (GMLAN_VAL_CLUSTER_UNITS_*)
+     */
+    void setUnits(uint8_t const units) {
+        renderer->setUnits(units, renderer->canRender());
+        rest.setUnits(units);
+    }
+
+    /**
+     * Hand a GMLAN message to the renderers selected by consumers
+     * @param consumers bitmask of renderers, bit N selects the renderer at index N
+     * @param arbId the Arbitration ID
+     * @param len the length of the buffer data
+     * @param buf the buffer data
+     */
+    void processMessage(uint8_t const consumers, uint32_t const arbId, uint8_t const len, uint8_t buf[8]) {
+        if (consumers & _BV(Index)) {
+            TELEMETRY(PROCESS, Index, arbId);
+            renderer->processMessage(arbId, len, buf);
+        }
+
+        rest.processMessage(consumers, arbId, len, buf);
+    }
+
+    /**
+     * Determine whether every renderer a layout places can render
+     * @param regions PROGMEM regions of the layout, one per renderer
+     * @return whether the layout can be shown
+     */
+    bool canRender(const Region* regions) {
+        if (!readRegion(regions + Index).isEmpty() && !renderer->canRender()) {
+            return false;
+        }
+
+        return rest.canRender(regions);
+    }
+
+    /**
+     * Move every renderer to its region in a layout
+     * A renderer whose region changed gives up its old region, which is marked dirty, so what is drawn there now
+     * replaces it, and draws everything again in its new region
+     * A renderer whose region stayed the same keeps what it drew
+     * @param flusher
+     * @param regions PROGMEM regions of the layout, one per renderer
+     * @param placed bitmask of renderers on the display, bit N for the renderer at index N, updated
+     */
+    void place(PageFlusher* flusher, const Region* regions, uint8_t& placed) {
+        const Region next = readRegion(regions + Index);
+        const bool shown = placed & _BV(Index);
+
+        if (shown ? renderer->getRegion() != next : !next.isEmpty()) {
+            if (shown) {
+                const Region& old = renderer->getRegion();
+                flusher->markDirty(old.x, old.y, old.w, old.h);
+                placed &= ~_BV(Index);
+            }
+
+            if (!next.isEmpty()) {
+                TELEMETRY(PLACE, Index, next.x, next.y, next.w, next.h);
+                renderer->place(next);
+                renderer->invalidate();
+                placed |= _BV(Index);
+            }
+        }
+
+        rest.place(flusher, regions, placed);
+    }
+
+    /**
+     * Render every renderer on the display which changed
+     * A renderer is only rendered again if it has new data, or it should render and its deadline passed
+     * @param placed bitmask of renderers on the display
+     */
+    void render(uint8_t const placed) {
+        if (placed & _BV(Index)) {
+            // also lets the renderer turn a deadline it reached into new data
+            const bool should = renderer->shouldRender();
+
+            if (renderer->isRenderPending() || (should && isDeadlineDue(renderer->getNextDeadline()))) {
+                TELEMETRY(RENDER, Index);
+                renderer->render();
+            }
+        }
+
+        rest.render(placed);
+    }
+
+    /**
+     * Draw every renderer on the display
+     * @param canvas the page being built
+     * @param placed bitmask of renderers on the display
+     */
+    void draw(PageCanvas& canvas, uint8_t const placed) const {
+        if (placed & _BV(Index)) {
+            renderer->draw(canvas);
+        }
+
+        rest.draw(canvas, placed);
+    }
+
+    /**
+     * Determine when the output of the renderers on the display will next change without new data
+     * @param placed bitmask of renderers on the display
+     * @return Clock::now() timestamp of the first change, or RENDERER_NO_DEADLINE
+     */
+    uint32_t getNextDeadline(uint8_t const placed) {
+        const uint32_t deadline = placed & _BV(Index) ? renderer->getNextDeadline() : RENDERER_NO_DEADLINE;
+        return earlierDeadline(deadline, rest.getNextDeadline(placed));
+    }
+
+    /**
+     * Call fn on every renderer, in priority order
+     * @tparam Fn callable taking any renderer by reference
+     * @param fn
+     */
+    template<typename Fn>
+    void forEach(Fn fn) {
+        fn(*renderer);
+        rest.forEach(fn);
+    }
+};
+
+/**
+ * The fixed set of renderers, in priority order with the most important renderer first, and where they are drawn
+ * Replaces an array of Renderer pointers, the renderer set is known at compile time so no call is virtual
+ *
+ * Renderers share the display by layouts, each gives some renderers a region, see ScreenLayout
+ * The first layout whose renderers can all render is shown, so the order of the layouts is the priority
+ * Each renderer only marks its own region dirty, so only what changed is drawn and sent, switching layouts only
+ * redraws the regions which moved
+ * @tparam Renderers renderer types, see Renderer for what each must provide
+ */
+template<typename... Renderers>
+class RendererPipeline {
+    RendererChain<0, Renderers...> chain;
+
+    /**
+     * PROGMEM layouts, in priority order
+     */
+    const ScreenLayout<sizeof...(Renderers)>* layouts;
+
+    /**
+     * Number of layouts
+     */
+    uint8_t layoutCount;
+
+    /**
+     * Index of the layout on the display, to avoid placing the same renderers twice
+     */
+    uint8_t layout = RENDERER_PIPELINE_NONE;
+
+    /**
+     * Bitmask of the renderers on the display, bit N for the renderer at index N
+     */
+    uint8_t placed = 0;
+
+    /**
+     * Whether the display holds drawing of no renderer on it, so all of it must be sent again
+     */
+    bool stale = false;
+
+    /**
+     * Find the first layout whose renderers can all render
+     * @return index of the layout, or RENDERER_PIPELINE_NONE
+     */
+    uint8_t chooseLayout() {
+        for (uint8_t i = 0; i < layoutCount; i++) {
+            if (chain.canRender(layouts[i].regions)) {
+                return i;
+            }
+        }
+
+        return RENDERER_PIPELINE_NONE;
+    }
+
+public:
+    /**
+     * Number of renderers
+     */
+    static constexpr uint8_t size = sizeof...(Renderers);
+
+    static_assert(size > 0 && size < 8, "renderer indexes must fit a consumers bitmask");
+
+    /**
+     * Regions of every renderer for one layout
+     */
+    using Layout = ScreenLayout<size>;
+
+    /**
+     * ArbRegistry of the given consumers followed by these renderers, so dispatch bits line up with renderer indexes
+     * @tparam Before consumers which come ahead of the renderers
+     */
+    template<typename... Before>
+    using Registry = ArbRegistry<Before..., Renderers...>;
+
+    /**
+     * Create a pipeline
+     * @param layouts PROGMEM layouts, in priority order, they must outlive the pipeline
+     * @param layoutCount number of layouts
+     * @param renderers one of each renderer, in the same order as the template arguments
+     */
+    RendererPipeline(const Layout* layouts, uint8_t const layoutCount, Renderers*... renderers)
+        : chain(renderers...), layouts(layouts), layoutCount(layoutCount) {}
+
+    /**
+     * Sets new cluster units on every renderer
+     * @param units the new unit data (GMLAN_VAL_CLUSTER_UNITS_*)
+     */
+    void setUnits(uint8_t const units) {
+        chain.setUnits(units);
+    }
+
+    /**
+     * Hand a GMLAN message to the renderers selected by consumers
+     * @param consumers bitmask of renderers, bit N selects the renderer at index N
+     * @param arbId the Arbitration ID
+     * @param len the length of the buffer data
+     * @param buf the buffer data
+     */
+    void processMessage(uint8_t const consumers, uint32_t const arbId, uint8_t const len, uint8_t buf[8]) {
+        chain.processMessage(consumers, arbId, len, buf);
+    }
+
+    /**
+     * Render data to display, based on the layouts
+     * The first layout whose renderers can all render is shown, a renderer which can render but is in no earlier
+     * layout does not take over on new data, this avoids oscillation in display choice
+     * Renderers new to their region draw all of it, the others only what changed
+     * If no layout can be shown, the display is cleared once and put to sleep
+     * Nothing is drawn while the previous frame is still being sent, it is picked up on a later call
+     * @param flusher
+     */
+    void render(PageFlusher* flusher) {
+        if (flusher->isBusy()) {
+            return; // the framebuffer is being sent, marking it dirty now would tear it
+        }
+
+        const uint8_t next = chooseLayout();
+
+        if (next == RENDERER_PIPELINE_NONE) {
+            if (layout != RENDERER_PIPELINE_NONE || stale) {
+                // forgetting the layout makes sure this only happens once
+                flusher->markAllDirty();
+                flusher->flush(FrameSource());
+                flusher->sleepDisplay();
+                layout = RENDERER_PIPELINE_NONE;
+                placed = 0;
+                stale = false;
+            }
+
+            return;
+        }
+
+        if (stale) {
+            flusher->markAllDirty();
+            stale = false;
+        }
+
+        if (next != layout) {
+            TELEMETRY(LAYOUT, next);
+            chain.place(flusher, layouts[next].regions, placed);
+            layout = next;
+        }
+
+        chain.render(placed);
+        flusher->flush(FrameSource::of(*this));
+    }
+
+    /**
+     * Draws every renderer on the display, the frame flushed by render()
+     * @param canvas the page being built
+     */
+    void draw(PageCanvas& canvas) const {
+        chain.draw(canvas, placed);
+    }
+
+    /**
+     * Determine when the display will next change without new data
+     * @return Clock::now() timestamp from the renderers on the display, whichever is first, or RENDERER_NO_DEADLINE
+     */
+    uint32_t getNextDeadline() {
+        return chain.getNextDeadline(placed);
+    }
+
+    /**
+     * Determine which layout is on the display
+     * @return index of the layout, or RENDERER_PIPELINE_NONE
+     */
+    [[nodiscard]] uint8_t getLayout() const {
+        return layout;
+    }
+
+    /**
+     * Forget what is on the display, so the next render() draws all of it again
+     */
+    void invalidate() {
+        layout = RENDERER_PIPELINE_NONE;
+        placed = 0;
+        stale = true;
+    }
+
+    /**
+     * Call fn on every renderer, in priority order
+     * @tparam Fn callable taking any renderer by reference, such as a generic lambda
+     * @param fn
+     */
+    template<typename Fn>
+    void forEach(Fn fn) {
+        chain.forEach(fn);
+    }
+};
+
+#endif //RENDERER_PIPELINE_H
@@ -0,0 +1,91 @@
+#ifndef RING_BUFFER_H
+#define RING_BUFFER_H
+
+#include <Arduino.h>
+
+// keeps the compiler from moving slot reads/writes across an index update
+#define RING_BUFFER_BARRIER() __asm__ __volatile__("" ::: "memory")
+
+/**
+ * Lock-free single-producer/single-consumer ring buffer
+ * The producer (usually an ISR) only writes head, the consumer only writes tail
+ * Indexes are single bytes, so reads and writes of them are atomic on AVR
+ * @tparam T type of element, copied in and out
+ * @tparam N capacity, must be a power of two no larger than 128
+ */
+template<typename T, uint8_t N>
+class RingBuffer {
+    static_assert(N > 0 && (N & (N - 1)) == 0, "RingBuffer capacity must be a power of two");
+    static_assert(N <= 128, "RingBuffer capacity must fit a single byte index");
+
+    /**
+     * Element storage
+     */
+    T slots[N];
+
+    /**
+     * Next slot to write, only changed by the producer
+     */
+    volatile uint8_t head = 0;
+
+    /**
+     * Next slot to read, only changed by the consumer
+     */
+    volatile uint8_t tail = 0;
+
+public:
+    /**
+     * Add an element, only call from the producer
+     * @param value the element to copy in
+     * @return false if the buffer was full and the element was not added
+     */
+    bool push(const T& value) {
+        const uint8_t current = head;
+        const auto next = static_cast<uint8_t>((current + 1) & (N - 1));
+
+        if (next == tail) {
+            return false;
+        }
+
+        slots[current] = value;
+        RING_BUFFER_BARRIER();
+        head = next;
+        return true;
+    }
+
+    /**
+     * Remove the oldest element, only call from the consumer
+     * @param value output for the element
+     * @return false if the buffer was empty
+     */
+    bool pop(T& value) {
+        const uint8_t current = tail;
+
+        if (current == head) {
+            return false;
+        }
+
+        value = slots[current];
+        RING_BUFFER_BARRIER();
+        tail = static_cast<uint8_t>((current + 1) & (N - 1));
+        return true;
+    }
+
+    /**
+     * Determine whether there is anything to read
+     * @return whether the buffer is empty
+     */
+    [[nodiscard]] bool isEmpty() const {
+        return head == tail;
+    }
+
+    /**
+     * Number of usable slots, one slot is always kept free to tell full from empty
+     * @return the capacity
+     */
+    static constexpr uint8_t capacity() {
+        return N - 1;
+    }
+};
+
+#endif //RING_BUFFER_H
@@ -0,0 +1,69 @@
+#include "SignalFilter.h"
+#include "Clock.h"
+#include "Deadline.h"
+
+/**
+ * Decide whether a new value should be drawn
+ * @param raw the new raw value
+ * @param value the new value as it would be displayed
+ * @param settings the signal's settings
+ * @return whether to draw it now, later, or not at all
+ */
+SignalChange SignalFilter::check(uint8_t const raw, int16_t const value, const SignalSettings& settings) const {
+    if (!hasShown) {
+        return SignalChange::NOW;
+    }
+
+    if (value == shownValue) {
+        return SignalChange::NONE;
+    }
+
+    const uint8_t distance = raw > shownRaw ? raw - shownRaw : shownRaw - raw;
+
+    if (distance <= settings.hysteresis) {
+        return SignalChange::NONE;
+    }
+
+    // subtracting keeps this correct when the clock overflows
+    if (Clock::now() - shownAt < settings.minIntervalMs) {
+        return SignalChange::LATER;
+    }
+
+    return SignalChange::NOW;
+}
+
+/**
+ * Record that a value was drawn
+ * @param raw the raw value
+ * @param value the value as displayed
+ */
+void SignalFilter::shown(uint8_t const raw, int16_t const value) {
+    shownRaw = raw;
+    shownValue = value;
+    shownAt = Clock::now();
+    hasShown = true;
+}
+
+/**
+ * Value on the display, as recorded by shown()
+ * @return the displayed value
+ */
+int16_t SignalFilter::getShownValue() const {
+    return shownValue;
+}
+
+/**
+ * Determine when a value held back by check() may be drawn
+ * @param settings the signal's settings
+ * @return Clock::now() timestamp, never RENDERER_NO_DEADLINE
+ */
+uint32_t SignalFilter::readyAt(const SignalSettings& settings) const {
+    return makeDeadline(shownAt + settings.minIntervalMs);
+}
+
+/**
+ * Forget the drawn value, so the next value is drawn straight away
+ */
+void SignalFilter::reset() {
+    hasShown = false;
+}
@@ -0,0 +1,93 @@
+#ifndef SIGNAL_FILTER_H
+#define SIGNAL_FILTER_H
+
+#include <Arduino.h>
+
+/**
+ * How a renderer decides that a new signal value is worth drawing, declared per signal next to ARB_IDS
+ */
+struct SignalSettings {
+    /**
+     * Raw changes up to this much from the value on the display are ignored, 0 to only compare displayed values
+     * A band of 1 stops a sensor alternating between two adjacent raw values from redrawing on every frame
+     */
+    uint8_t hysteresis;
+
+    /**
+     * Minimum time between two redraws of this signal in ms, 0 for no limit
+     * A change arriving sooner is drawn once the interval has passed
+     */
+    uint16_t minIntervalMs;
+};
+
+/**
+ * Outcome of SignalFilter::check()
+ */
+enum class SignalChange : uint8_t {
+    NONE,  // nothing visible would change, or the change is within the hysteresis band
+    NOW,   // draw now
+    LATER, // draw at SignalFilter::readyAt()
+};
+
+/**
+ * Remembers what a renderer last drew for one signal, to suppress redraws which would not change the display
+ * Values are compared as displayed, after unit conversion and rounding, not as the raw GMLAN byte
+ */
+class SignalFilter {
+    /**
+     * Raw value on the display
+     */
+    uint8_t shownRaw = 0;
+
+    /**
+     * Displayed value on the display
+     */
+    int16_t shownValue = 0;
+
+    /**
+     * Clock::now() timestamp of when it was drawn
+     */
+    uint32_t shownAt = 0;
+
+    /**
+     * Whether anything was drawn since the last reset()
+     */
+    bool hasShown = false;
+
+public:
+    /**
+     * Decide whether a new value should be drawn
+     * @param raw the new raw value
+     * @param value the new value as it would be displayed
+     * @param settings the signal's settings
+     * @return whether to draw it now, later, or not at all
+     */
+    SignalChange check(uint8_t raw, int16_t value, const SignalSettings& settings) const;
+
+    /**
+     * Record that a value was drawn
+     * @param raw the raw value
+     * @param value the value as displayed
+     */
+    void shown(uint8_t raw, int16_t value);
+
+    /**
+     * Value on the display, as recorded by shown()
+     * @return the displayed value
+     */
+    [[nodiscard]] int16_t getShownValue() const;
+
+    /**
+     * Determine when a value held back by check() may be drawn
+     * @param settings the signal's settings
+     * @return Clock::now() timestamp, never RENDERER_NO_DEADLINE
+     */
+    [[nodiscard]] uint32_t readyAt(const SignalSettings& settings) const;
+
+    /**
+     * Forget the drawn value, so the next value is drawn straight away
+     */
+    void reset();
+};
+
+#endif //SIGNAL_FILTER_H
@@ -0,0 +1,90 @@
+#include <util/atomic.h>
+
+#include "SpiBus.h"
+#include "CanReceiver.h"
+
+static volatile uint16_t preemptions = 0;
+
+/**
+ * Start a foreground transaction for a device other than the CAN controller
+ * Call from the main loop, never while a background transfer runs
+ * @param settings the device's SPI settings
+ */
+void SpiBus::beginTransaction(const SPISettings& settings) {
+    CanReceiver::hold();
+    SPI.beginTransaction(settings);
+}
+
+/**
+ * End a foreground transaction, the CAN interrupt then runs if the controller asked meanwhile
+ */
+void SpiBus::endTransaction() {
+    SPI.endTransaction();
+
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+        CanReceiver::release();
+    }
+}
+
+/**
+ * Take the bus for a background transfer
+ * Call before the first transaction, from the main loop
+ */
+void SpiBus::beginBackground() {
+    CanReceiver::hold();
+}
+
+/**
+ * Set the bus clock and mode for the next background transaction
+ * A background transaction runs from the SPI interrupt, with SPIE set, so SPI.beginTransaction() is only borrowed to
+ * write the settings, the bus is already held from beginBackground()
+ * This also clears SPIE, the caller sets it again
+ * @param settings the device's SPI settings
+ */
+void SpiBus::configure(const SPISettings& settings) {
+    SPI.beginTransaction(settings);
+    SPI.endTransaction();
+}
+
+/**
+ * Let the CAN controller use the bus between two background transactions, if it is waiting
+ * The controller is read with its own SPI settings, so the next background transaction must configure() again
+ * No chip select may be asserted, only call with interrupts disabled
+ */
+void SpiBus::yield() {
+    if (CanReceiver::isPending()) {
+        CanReceiver::drain();
+        preemptions++;
+    }
+}
+
+/**
+ * Give the bus back after the last background transaction
+ * Only call with interrupts disabled
+ */
+void SpiBus::endBackground() {
+    CanReceiver::release();
+}
+
+/**
+ * Number of times the CAN controller was serviced between background transactions
+ * @return the count
+ */
+uint16_t SpiBus::getPreemptions() {
+    uint16_t count;
+
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+        count = preemptions;
+    }
+
+    return count;
+}
+
+/**
+ * Reset the preemption counter
+ */
+void SpiBus::clearCounters() {
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+        preemptions = 0;
+    }
+}
@@ -0,0 +1,67 @@
+#ifndef SPI_BUS_H
+#define SPI_BUS_H
+
+#include <Arduino.h>
+#include <SPI.h>
+
+/**
+ * Arbitration of SPI0 between the MCP25625 and the SSD1306
+ * The CAN controller is read from its interrupt, with ordinary SPI transactions, whenever it asks
+ * Every other transaction holds off only that interrupt, see CanReceiver::hold(), so timers and the UART keep running
+ * OLED commands are sent in the foreground, with beginTransaction() and endTransaction()
+ * OLED pages are sent in the background, one transaction per page, see PageFlusher
+ * While a background transfer owns the bus, the CAN interrupt is held off, and the CAN controller
+ * is instead serviced between transactions, so a frame never waits longer than one OLED page
+ */
+class SpiBus {
+public:
+    /**
+     * Start a foreground transaction for a device other than the CAN controller
+     * Call from the main loop, never while a background transfer runs
+     * @param settings the device's SPI settings
+     */
+    static void beginTransaction(const SPISettings& settings);
+
+    /**
+     * End a foreground transaction, the CAN interrupt then runs if the controller asked meanwhile
+     */
+    static void endTransaction();
+
+    /**
+     * Take the bus for a background transfer
+     * Call before the first transaction, from the main loop
+     */
+    static void beginBackground();
+
+    /**
+     * Set the bus clock and mode for the next background transaction
+     * Anything else on the bus may have changed them since the last one
+     * @param settings the device's SPI settings
+     */
+    static void configure(const SPISettings& settings);
+
+    /**
+     * Let the CAN controller use the bus between two background transactions, if it is waiting
+     * No chip select may be asserted, only call with interrupts disabled
+     */
+    static void yield();
+
+    /**
+     * Give the bus back after the last background transaction
+     * Only call with interrupts disabled
+     */
+    static void endBackground();
+
+    /**
+     * Number of times the CAN controller was serviced between background transactions
+     * @return the count
+     */
+    [[nodiscard]] static uint16_t getPreemptions();
+
+    /**
+     * Reset the preemption counter
+     */
+    static void clearCounters();
+};
+
+#endif //SPI_BUS_H
@@ -0,0 +1,30 @@
+#ifndef STATIC_OBJECT_H
+#define STATIC_OBJECT_H
+
+#include <Arduino.h>
+#include <new>
+
+/**
+ * Storage for one long-lived object, reserved at link time instead of taken from the heap
+ * Declare as a static local, then create() the object once, so RAM use shows up in .bss
+ * The object is never destroyed, so no destructor is registered
+ * @tparam T the object type
+ */
+template<typename T>
+class StaticObject {
+    alignas(T) uint8_t storage[sizeof(T)];
+
+public:
+    /**
+     * Construct the object in the storage
+     * @tparam Args constructor argument types
+     * @param args constructor arguments
+     * @return the object
+     */
+    template<typename... Args>
+    T* create(Args... args) {
+        return new (storage) T(args...);
+    }
+};
+
+#endif //STATIC_OBJECT_H
@@ -0,0 +1,111 @@
+#include "Telemetry.h"
+#include "Debug.h"
+
+#ifdef HAL_NATIVE
+#include <cstdarg>
+#include <cstdio>
+#endif
+
+#if DO_DEBUG == 1
+// DROPPED record, the event ID and a 2 byte count, framed
+static constexpr uint8_t DROPPED_RECORD_SIZE = 1 + 2 + TELEMETRY_FRAMING_SIZE;
+
+// records dropped since the last DROPPED event
+static uint16_t dropped = 0;
+
+#ifdef HAL_NATIVE
+static const char* const texts[] = {
+#define TELEMETRY_EVENT_TEXT(name, layout, text) text,
+    TELEMETRY_EVENTS(TELEMETRY_EVENT_TEXT)
+#undef TELEMETRY_EVENT_TEXT
+};
+#endif
+
+/**
+ * Frame a record, COBS replaces each TELEMETRY_SYNC in it, so only the bytes around it are TELEMETRY_SYNC
+ * Each code byte gives the distance to the next TELEMETRY_SYNC of the record, or past its end
+ * Records are shorter than 254 bytes, so a single code byte can always reach the next one
+ * @param record the event ID and arguments
+ * @param length its length
+ * @param frame output, length + TELEMETRY_FRAMING_SIZE bytes
+ */
+static void frameRecord(const uint8_t* record, uint8_t const length, uint8_t* frame) {
+    uint8_t code = 0;
+    uint8_t out = 2;
+
+    frame[0] = TELEMETRY_SYNC;
+
+    for (uint8_t i = 0; i < length; i++, out++) {
+        if (record[i] == TELEMETRY_SYNC) {
+            frame[out - code - 1] = code + 1;
+            code = 0;
+        } else {
+            frame[out] = record[i];
+            code++;
+        }
+    }
+
+    frame[out - code - 1] = code + 1;
+    frame[out] = TELEMETRY_SYNC;
+}
+
+/**
+ * Queue a record for the UART, or drop it if there is no room
+ * Pending drops are reported first, only once both records fit, so the report never takes the place of an event
+ * @param record the event ID and arguments, framing is added here
+ * @param length its length, at most TELEMETRY_PAYLOAD_MAX
+ */
+void Telemetry::send(const uint8_t* record, uint8_t const length) {
+    if (Debug::muted) {
+        return;
+    }
+
+    const int room = Serial.availableForWrite();
+    const uint8_t framed = length + TELEMETRY_FRAMING_SIZE;
+    const uint8_t needed = dropped ? framed + DROPPED_RECORD_SIZE : framed;
+
+    if (room < needed) {
+        if (dropped < UINT16_MAX) {
+            dropped++;
+        }
+
+        return;
+    }
+
+    uint8_t frame[TELEMETRY_PAYLOAD_MAX + TELEMETRY_FRAMING_SIZE];
+
+    if (dropped) {
+        const uint8_t report[] = {
+            static_cast<uint8_t>(TelemetryEvent::DROPPED),
+            static_cast<uint8_t>(dropped),
+            static_cast<uint8_t>(dropped >> 8)
+        };
+
+        frameRecord(report, sizeof(report), frame);
+        Serial.write(frame, DROPPED_RECORD_SIZE);
+        dropped = 0;
+    }
+
+    frameRecord(record, length, frame);
+    Serial.write(frame, framed);
+}
+
+#ifdef HAL_NATIVE
+/**
+ * Print an event as text, stdout never fills up so nothing is dropped
+ * @param event the event ID
+ * @param ... its arguments
+ */
+void Telemetry::print(unsigned const event, ...) {
+    if (Debug::muted) {
+        return;
+    }
+
+    va_list args;
+    va_start(args, event);
+    vprintf(texts[event], args);
+    va_end(args);
+    putchar('\n');
+}
+#endif
+#endif
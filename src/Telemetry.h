@@ -0,0 +1,152 @@
+#ifndef TELEMETRY_H
+#define TELEMETRY_H
+
+#include <Arduino.h>
+#include "TelemetryEvents.h"
+
+// first and last byte of every record, console text never contains it and COBS keeps it out of the records
+#define TELEMETRY_SYNC 0x00
+
+// longest record before framing, the event ID and its arguments
+#define TELEMETRY_PAYLOAD_MAX 8
+
+// bytes framing adds to a record, a sync byte on either side and the COBS code byte of a record under 254 bytes
+#define TELEMETRY_FRAMING_SIZE 3
+
+#if DO_DEBUG == 1
+    #define TELEMETRY(EVENT, ...) Telemetry::log<TelemetryEvent::EVENT>(__VA_ARGS__)
+#else
+    #define TELEMETRY(EVENT, ...)
+#endif
+
+/**
+ * Event IDs, in TelemetryEvents.h order
+ */
+enum class TelemetryEvent : uint8_t {
+#define TELEMETRY_EVENT_ID(name, layout, text) name,
+    TELEMETRY_EVENTS(TELEMETRY_EVENT_ID)
+#undef TELEMETRY_EVENT_ID
+};
+
+/**
+ * Binary event log for the hot paths, replacing formatted DEBUG() output there
+ * A record is the event ID, then the raw argument bytes, COBS encoded between two TELEMETRY_SYNC bytes
+ * That is 4-9 bytes instead of a 30-50 character line, and an argument byte can never be taken for the start of a record
+ * Records go into the serial TX ring, which the UART interrupt drains, a record which doesn't fit is dropped and counted
+ * rather than waiting for room, the count is sent as a DROPPED event once there is room again
+ * Formatting happens on the host, see scripts/decode_telemetry.py, native builds print the text directly
+ * Log with TELEMETRY(), which compiles to nothing without DO_DEBUG, only from the main loop
+ */
+class Telemetry {
+    /**
+     * Argument layout of each event, only used at compile time
+     */
+    static constexpr const char* layouts[] = {
+#define TELEMETRY_EVENT_LAYOUT(name, layout, text) layout,
+        TELEMETRY_EVENTS(TELEMETRY_EVENT_LAYOUT)
+#undef TELEMETRY_EVENT_LAYOUT
+    };
+
+    /**
+     * Size of an argument in an event layout
+     * @param code Python struct code
+     * @return size in bytes, 0 if the code is not supported
+     */
+    static constexpr uint8_t codeSize(char const code) {
+        return code == 'B' || code == 'b' ? 1 : code == 'H' || code == 'h' ? 2 : code == 'I' || code == 'i' ? 4 : 0;
+    }
+
+    /**
+     * Determine whether arguments fit an event layout, one by one
+     * @tparam Args argument types
+     * @param layout the event layout
+     * @return whether they match
+     */
+    template<typename... Args>
+    static constexpr bool matchesLayout(const char* layout) {
+        constexpr uint8_t sizes[] = {sizeof(Args)..., 0};
+        uint8_t i = 0;
+
+        for (; layout[i] != '\0'; i++) {
+            if (i >= sizeof...(Args) || sizes[i] != codeSize(layout[i])) {
+                return false;
+            }
+        }
+
+        return i == sizeof...(Args);
+    }
+
+    /**
+     * Queue a record for the UART, or drop it if there is no room
+     * @param record the event ID and arguments, framing is added here
+     * @param length its length, at most TELEMETRY_PAYLOAD_MAX
+     */
+    static void send(const uint8_t* record, uint8_t length);
+
+#ifdef HAL_NATIVE
+    /**
+     * Print an event as text
+     * @param event the event ID
+     * @param ... its arguments, widened by printArgument()
+     */
+    static void print(unsigned event, ...);
+
+    /**
+     * Pass an argument to print() as the event texts expect, 4 byte arguments are printed with %l conversions
+     * @param arg the argument
+     * @return the argument as unsigned long
+     */
+    static unsigned long printArgument(uint32_t const arg) {
+        return arg;
+    }
+
+    /**
+     * Pass an argument to print() as the event texts expect, 4 byte arguments are printed with %l conversions
+     * @param arg the argument
+     * @return the argument as long
+     */
+    static long printArgument(int32_t const arg) {
+        return arg;
+    }
+
+    /**
+     * Pass an argument to print() as the event texts expect, smaller arguments are promoted to int
+     * @tparam T argument type
+     * @param arg the argument
+     * @return the argument as it is
+     */
+    template<typename T>
+    static T printArgument(T const arg) {
+        return arg;
+    }
+#endif
+
+public:
+    /**
+     * Log an event, never waits for the UART
+     * @tparam Event the event
+     * @tparam Args argument types, their sizes must match the event layout
+     * @param args the arguments
+     */
+    template<TelemetryEvent Event, typename... Args>
+    static void log(Args... args) {
+        static_assert(
+            matchesLayout<Args...>(layouts[static_cast<uint8_t>(Event)]),
+            "arguments must match the event layout in TelemetryEvents.h"
+        );
+
+#ifdef HAL_NATIVE
+        print(static_cast<uint8_t>(Event), printArgument(args)...);
+#else
+        static_assert(1 + (0 + ... + sizeof(Args)) <= TELEMETRY_PAYLOAD_MAX, "record must fit TELEMETRY_PAYLOAD_MAX");
+
+        // the AVR is little-endian, like the layouts, so arguments are copied as they are
+        uint8_t record[1 + (0 + ... + sizeof(Args))] = {static_cast<uint8_t>(Event)};
+        uint8_t* out = record + 1;
+        ((memcpy(out, &args, sizeof(args)), out += sizeof(args)), ...);
+        send(record, sizeof(record));
+#endif
+    }
+};
+
+#endif //TELEMETRY_H
@@ -0,0 +1,33 @@
+#ifndef TELEMETRY_EVENTS_H
+#define TELEMETRY_EVENTS_H
+
+/*
+ * Every telemetry event, see Telemetry
+ * X(name, argument layout, text)
+ *
+ * The event ID is the position in this list, so only ever append, or the decoder and firmware disagree
+ * The layout gives each argument in Python struct codes, little-endian: B/b 1 byte, H/h 2 bytes, I/i 4 bytes
+ * The text is a printf format taking the arguments in order, it never goes into the firmware
+ * 4 byte arguments take %l conversions, such as %lu or %08lx, native builds widen them to long to match
+ * scripts/decode_telemetry.py reads this file, so keep each event on one line
+ */
+#define TELEMETRY_EVENTS(X) \
+    X(DROPPED,           "H",    "Telemetry dropped %u events") \
+    X(CAN_FRAME,         "IB",   "Checking ARB ID 0x%08lx consumers=0x%02x") \
+    X(CLUSTER_UNITS,     "B",    "New cluster units: 0x%02x") \
+    X(PROCESS,           "BI",   "Processing via renderer %u ARB ID 0x%08lx") \
+    X(RENDER,            "B",    "Rendering via renderer %u") \
+    X(PLACE,             "BBBBB", "Placing renderer %u at %u,%u size %ux%u") \
+    X(TEMPERATURE,       "B",    "Got temperature: 0x%02x") \
+    X(TEMPERATURE_DRAW,  "h",    "Render Temperature %d") \
+    X(PARK_ASSIST_ON,    "B",    "PA ON, distance: %ucm") \
+    X(PARK_ASSIST_OFF,   "",     "PA OFF") \
+    X(PARK_ASSIST_OTHER, "B",    "PA Unknown value %u") \
+    X(UNITS_SAVED,       "B",    "saveUnits() units=%x") \
+    X(FLASH_COMMITTED,   "HH",   "Flash committed sequence=%u slot=%u") \
+    X(LAYOUT,            "B",    "Showing layout %u") \
+    X(TEMPERATURE_SAVED, "B",    "saveTemperature() temperature=%x") \
+    X(TEMPERATURE_RESTORED, "BB", "Restored temperature 0x%02x from %u power-ups ago") \
+    X(FIRST_FRAME,       "I",    "First frame shown %lu ms after boot")
+
+#endif //TELEMETRY_EVENTS_H
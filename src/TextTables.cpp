@@ -0,0 +1,169 @@
+#include "TextTables.h"
+#include "TextTablesData.h" // generated into the build directory by scripts/generate_text_tables.py
+#include "GMLan.h"
+#include "Units.h"
+
+static_assert(TEXT_TABLE_LONGEST < TEXT_TABLE_MAX_LEN, "TEXT_TABLE_MAX_LEN is too small for generated text");
+static_assert(
+    Units::rawToCelsius(0) >= TEXT_TABLE_TEMPERATURE_C_MIN && Units::rawToCelsius(0xFF) <= TEXT_TABLE_TEMPERATURE_C_MAX,
+    "Celsius table does not cover every temperature"
+);
+static_assert(
+    Units::rawToFahrenheit(0) >= TEXT_TABLE_TEMPERATURE_F_MIN && Units::rawToFahrenheit(0xFF) <= TEXT_TABLE_TEMPERATURE_F_MAX,
+    "Fahrenheit table does not cover every temperature"
+);
+static_assert(Units::centimetersToInches(0xFF) <= TEXT_TABLE_DISTANCE_IN_MAX, "inch table does not cover every distance");
+static_assert(TEXT_TABLE_BUILT_IN_ADVANCE == TEXT_BUILT_IN_ADVANCE, "TEXT_BUILT_IN_ADVANCE does not match the generated font");
+
+// suffixes, these must match the strings built by scripts/generate_text_tables.py
+// extra space is to make room for degree symbol, which isn't available in font
+static const char SUFFIX_CELSIUS[] PROGMEM = "  C";
+static const char SUFFIX_FAHRENHEIT[] PROGMEM = "  F";
+static const char SUFFIX_COMPACT_CELSIUS[] PROGMEM = " C";
+static const char SUFFIX_COMPACT_FAHRENHEIT[] PROGMEM = " F";
+static const char SUFFIX_CM[] PROGMEM = "cm";
+static const char SUFFIX_FT[] PROGMEM = "ft ";
+static const char SUFFIX_IN[] PROGMEM = "in";
+
+/**
+ * Clamp a value into a table's range
+ * @param value the value
+ * @param min first value in the table
+ * @param max last value in the table
+ * @return the table index
+ */
+static uint8_t tableIndex(int16_t const value, int16_t const min, int16_t const max) {
+    if (value < min) {
+        return 0;
+    }
+
+    if (value > max) {
+        return static_cast<uint8_t>(max - min);
+    }
+
+    return static_cast<uint8_t>(value - min);
+}
+
+/**
+ * Copy a number from the number pool
+ * @param out where to write, advanced past the written text
+ * @param number the number
+ */
+static void appendNumber(char*& out, int16_t const number) {
+    const uint16_t index = number - TEXT_TABLE_NUMBER_MIN;
+    strcpy_P(out, textTableNumbers[index]);
+    out += strlen(out);
+}
+
+/**
+ * Copy a suffix
+ * @param out where to write, advanced past the written text
+ * @param suffix the PROGMEM suffix
+ */
+static void appendSuffix(char*& out, const char* suffix) {
+    strcpy_P(out, suffix);
+    out += strlen(out);
+}
+
+/**
+ * Copy a size from a table
+ * @param table the PROGMEM table
+ * @param index the table index
+ * @param layout output for size
+ */
+static void readSize(const uint8_t (*table)[2], uint8_t const index, TextLayout& layout) {
+    layout.width = pgm_read_byte(&table[index][0]);
+    layout.height = pgm_read_byte(&table[index][1]);
+}
+
+/**
+ * Temperature text in FreeSans18pt7b
+ * @param degrees temperature in the display units, clamped to the table range
+ * @param units the unit data (GMLAN_VAL_CLUSTER_UNITS_*)
+ * @param layout output for text and size
+ */
+void TextTables::getTemperature(int16_t const degrees, uint8_t const units, TextLayout& layout) {
+    char* out = layout.text;
+
+    if (units == GMLAN_VAL_CLUSTER_UNITS_IMPERIAL) {
+        const auto index = tableIndex(degrees, TEXT_TABLE_TEMPERATURE_F_MIN, TEXT_TABLE_TEMPERATURE_F_MAX);
+        appendNumber(out, static_cast<int16_t>(index + TEXT_TABLE_TEMPERATURE_F_MIN));
+        appendSuffix(out, SUFFIX_FAHRENHEIT);
+        readSize(textTableTemperatureF, index, layout);
+        layout.font = &TEXT_TABLE_TEMPERATURE_F_FONT;
+    } else {
+        const auto index = tableIndex(degrees, TEXT_TABLE_TEMPERATURE_C_MIN, TEXT_TABLE_TEMPERATURE_C_MAX);
+        appendNumber(out, static_cast<int16_t>(index + TEXT_TABLE_TEMPERATURE_C_MIN));
+        appendSuffix(out, SUFFIX_CELSIUS);
+        readSize(textTableTemperatureC, index, layout);
+        layout.font = &TEXT_TABLE_TEMPERATURE_C_FONT;
+    }
+}
+
+/**
+ * Temperature text in the built-in 5x7 font, for a region too small for getTemperature()
+ * The built-in font is fixed width, so the size needs no table, the space before the unit is for the degree symbol
+ * @param degrees temperature in the display units, clamped to the table range
+ * @param units the unit data (GMLAN_VAL_CLUSTER_UNITS_*)
+ * @param layout output for text and size
+ */
+void TextTables::getCompactTemperature(int16_t const degrees, uint8_t const units, TextLayout& layout) {
+    char* out = layout.text;
+
+    if (units == GMLAN_VAL_CLUSTER_UNITS_IMPERIAL) {
+        const auto index = tableIndex(degrees, TEXT_TABLE_TEMPERATURE_F_MIN, TEXT_TABLE_TEMPERATURE_F_MAX);
+        appendNumber(out, static_cast<int16_t>(index + TEXT_TABLE_TEMPERATURE_F_MIN));
+        appendSuffix(out, SUFFIX_COMPACT_FAHRENHEIT);
+    } else {
+        const auto index = tableIndex(degrees, TEXT_TABLE_TEMPERATURE_C_MIN, TEXT_TABLE_TEMPERATURE_C_MAX);
+        appendNumber(out, static_cast<int16_t>(index + TEXT_TABLE_TEMPERATURE_C_MIN));
+        appendSuffix(out, SUFFIX_COMPACT_CELSIUS);
+    }
+
+    // the column after the last character is spacing
+    layout.width = static_cast<uint8_t>((out - layout.text) * TEXT_BUILT_IN_ADVANCE - 1);
+    layout.height = TEXT_BUILT_IN_HEIGHT;
+    layout.font = &TEXT_BUILT_IN_FONT;
+}
+
+/**
+ * Distance text in FreeSans9pt7b
+ * @param distance distance in centimeters or inches depending on units, clamped to the table range
+ * @param units the unit data (GMLAN_VAL_CLUSTER_UNITS_*)
+ * @param layout output for text and size
+ */
+void TextTables::getDistance(uint8_t const distance, uint8_t const units, TextLayout& layout) {
+    char* out = layout.text;
+
+    if (units == GMLAN_VAL_CLUSTER_UNITS_IMPERIAL) {
+        const auto index = tableIndex(distance, TEXT_TABLE_DISTANCE_IN_MIN, TEXT_TABLE_DISTANCE_IN_MAX);
+        const auto inches = static_cast<uint8_t>(index + TEXT_TABLE_DISTANCE_IN_MIN);
+        const auto feet = static_cast<uint8_t>(inches / 12);
+
+        // only show feet if there is at least 1 foot
+        if (feet > 0) {
+            appendNumber(out, feet);
+            appendSuffix(out, SUFFIX_FT);
+        }
+
+        appendNumber(out, static_cast<int16_t>(inches - feet * 12));
+        appendSuffix(out, SUFFIX_IN);
+        readSize(textTableDistanceIn, index, layout);
+        layout.font = &TEXT_TABLE_DISTANCE_IN_FONT;
+    } else {
+        const auto index = tableIndex(distance, TEXT_TABLE_DISTANCE_CM_MIN, TEXT_TABLE_DISTANCE_CM_MAX);
+        appendNumber(out, static_cast<int16_t>(index + TEXT_TABLE_DISTANCE_CM_MIN));
+        appendSuffix(out, SUFFIX_CM);
+        readSize(textTableDistanceCm, index, layout);
+        layout.font = &TEXT_TABLE_DISTANCE_CM_FONT;
+    }
+}
+
+/**
+ * Adafruit GFX built-in 5x7 font, for the compact temperature, and BusDiagnostics in debug builds
+ * Only holds the characters its lines use, glyphs are placed by their top row, as Adafruit_GFX::setCursor() places them
+ * @return PROGMEM font
+ */
+const PageFont* TextTables::getBuiltInFont() {
+    return &TEXT_BUILT_IN_FONT;
+}
@@ -0,0 +1,62 @@
+#ifndef TEXT_TABLES_H
+#define TEXT_TABLES_H
+
+#include <Arduino.h>
+#include "GlyphBlitter.h"
+
+// longest string built, including NUL - examples "-40  F" or "190  F" or "255cm" or "8ft 4in"
+#define TEXT_TABLE_MAX_LEN 10
+
+// built-in font measurements, the advance is checked against the generated font, glyphs use the top 7 of 8 rows
+#define TEXT_BUILT_IN_ADVANCE 6
+#define TEXT_BUILT_IN_HEIGHT 7
+
+/**
+ * A string, with the font it will be drawn with and its size in that font
+ */
+struct TextLayout {
+    char text[TEXT_TABLE_MAX_LEN];
+    uint8_t width;
+    uint8_t height;
+    const PageFont* font;
+};
+
+/**
+ * Text for the renderers, built from PROGMEM tables generated by scripts/generate_text_tables.py
+ * Sizes match Adafruit_GFX::getTextBounds(), without reading any glyph metrics while rendering
+ * Fonts only hold the characters these strings use, draw them with GlyphBlitter
+ */
+class TextTables {
+public:
+    /**
+     * Temperature text in FreeSans18pt7b
+     * @param degrees temperature in the display units, clamped to the table range
+     * @param units the unit data (GMLAN_VAL_CLUSTER_UNITS_*)
+     * @param layout output for text and size
+     */
+    static void getTemperature(int16_t degrees, uint8_t units, TextLayout& layout);
+
+    /**
+     * Temperature text in the built-in 5x7 font, for a region too small for getTemperature()
+     * @param degrees temperature in the display units, clamped to the table range
+     * @param units the unit data (GMLAN_VAL_CLUSTER_UNITS_*)
+     * @param layout output for text and size
+     */
+    static void getCompactTemperature(int16_t degrees, uint8_t units, TextLayout& layout);
+
+    /**
+     * Distance text in FreeSans9pt7b
+     * @param distance distance in centimeters or inches depending on units, clamped to the table range
+     * @param units the unit data (GMLAN_VAL_CLUSTER_UNITS_*)
+     * @param layout output for text and size
+     */
+    static void getDistance(uint8_t distance, uint8_t units, TextLayout& layout);
+
+    /**
+     * Adafruit GFX built-in 5x7 font, for the compact temperature, and BusDiagnostics in debug builds
+     * @return PROGMEM font
+     */
+    static const PageFont* getBuiltInFont();
+};
+
+#endif //TEXT_TABLES_H
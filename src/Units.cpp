@@ -0,0 +1,55 @@
+#include "Units.h"
+
+/*
+ * Exhaustive checks of every conversion against the floating point formulas they replace
+ * Only on the host: double is 32 bits on AVR, which is not precise enough to be the reference
+ */
+#ifdef HAL_NATIVE
+
+/**
+ * Round half away from zero, like lround()
+ * @param value the value
+ * @return the rounded value
+ */
+static constexpr long referenceRound(double const value) {
+    return value < 0 ? -static_cast<long>(-value + 0.5) : static_cast<long>(value + 0.5);
+}
+
+/**
+ * Compare every temperature byte with the floating point conversions
+ * @return whether all match
+ */
+static constexpr bool checkTemperatures() {
+    for (uint16_t raw = 0; raw <= 0xFF; raw++) {
+        const double celsius = raw / 2.0 - 40;
+
+        if (Units::rawToCelsius(raw) != referenceRound(celsius)) {
+            return false;
+        }
+
+        if (Units::rawToFahrenheit(raw) != referenceRound(1.8 * celsius + 32)) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+/**
+ * Compare every distance with the floating point conversion
+ * @return whether all match
+ */
+static constexpr bool checkDistances() {
+    for (uint16_t cm = 0; cm <= 0xFF; cm++) {
+        if (Units::centimetersToInches(cm) != referenceRound(cm / 2.54)) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+static_assert(checkTemperatures(), "temperature conversion differs from floating point");
+static_assert(checkDistances(), "distance conversion differs from floating point");
+
+#endif
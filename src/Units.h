@@ -0,0 +1,58 @@
+#ifndef UNITS_H
+#define UNITS_H
+
+#include <Arduino.h>
+
+// GMLAN temperature byte is 2 * (C + 40), so its offset in half degrees is 80
+#define UNITS_TEMPERATURE_OFFSET_HALVES 80
+
+/**
+ * Unit conversions for GMLAN data, in integer math with correct rounding (half away from zero, like lround())
+ * Everything is constexpr, so constant arguments cost nothing, see Units.cpp for the exhaustive checks
+ */
+class Units {
+public:
+    /**
+     * Divide, rounding half away from zero
+     * @param numerator the numerator
+     * @param denominator the denominator, must be positive
+     * @return the rounded quotient
+     */
+    static constexpr int16_t roundedDivide(int16_t const numerator, int16_t const denominator) {
+        return static_cast<int16_t>(
+            numerator < 0
+                ? -((-numerator + denominator / 2) / denominator)
+                : (numerator + denominator / 2) / denominator
+        );
+    }
+
+    /**
+     * Temperature from the GMLAN byte, in Celsius
+     * @param raw 2 * (C + 40)
+     * @return the temperature, rounded from half degrees
+     */
+    static constexpr int16_t rawToCelsius(uint8_t const raw) {
+        return roundedDivide(static_cast<int16_t>(raw - UNITS_TEMPERATURE_OFFSET_HALVES), 2);
+    }
+
+    /**
+     * Temperature from the GMLAN byte, in Fahrenheit
+     * Converted from half degrees Celsius, not the rounded Celsius value: F = 1.8 * (raw / 2 - 40) + 32 = (9 * raw - 400) / 10
+     * @param raw 2 * (C + 40)
+     * @return the temperature
+     */
+    static constexpr int16_t rawToFahrenheit(uint8_t const raw) {
+        return roundedDivide(static_cast<int16_t>(9 * raw - 400), 10);
+    }
+
+    /**
+     * Distance in inches, 2.54 cm per inch
+     * @param cm distance in centimeters
+     * @return the distance
+     */
+    static constexpr uint8_t centimetersToInches(uint8_t const cm) {
+        return static_cast<uint8_t>(roundedDivide(static_cast<int16_t>(cm * 50), 127));
+    }
+};
+
+#endif //UNITS_H
@@ -1,6 +1,52 @@
 #include "Watchdog.h"
+#include "Flash.h"
+#include "Clock.h"
 #include "Debug.h"
 
+/*
+ * Kept through a reset, the C runtime neither clears nor initializes .noinit
+ * After a power-on or brown-out reset the contents are garbage
+ */
+#ifdef HAL_NATIVE
+#define WATCHDOG_NOINIT
+#else
+#define WATCHDOG_NOINIT __attribute__((section(".noinit")))
+#endif
+
+// marks a reset requested by resetNow(), any other value means it was not
+static constexpr uint8_t ERROR_LIMIT_MARKER = 0xA5;
+
+static uint8_t resetFlags WATCHDOG_NOINIT;
+static uint8_t resetMarker WATCHDOG_NOINIT;
+static volatile WatchdogStage stage WATCHDOG_NOINIT;
+
+// main loop supervision
+static uint32_t loopStart = 0;
+static uint8_t overrunStreak = 0;
+static uint16_t overruns = 0;
+static uint16_t longestLoopMs = 0;
+
+#ifndef HAL_NATIVE
+/**
+ * Copy and clear the reset flags before the C runtime starts, see Watchdog::logReset()
+ * A WDT reset leaves the WDT running at its shortest timeout, so it is stopped here, before it can fire again
+ * Optiboot clears MCUSR itself and hands the flags over in r2
+ */
+void captureResetFlags() __attribute__((naked, used, section(".init3")));
+
+void captureResetFlags() {
+    uint8_t flags = MCUSR;
+
+    if (flags == 0) {
+        asm volatile("mov %0, r2" : "=r"(flags));
+    }
+
+    resetFlags = flags;
+    MCUSR = 0;
+    wdt_disable();
+}
+#endif
+
 /**
  * Create an error handler watchdog
  * @param limit number of errors before a reboot
@@ -32,12 +78,167 @@ void Watchdog::countError() {
 
 /**
  * Force an immediate reboot
+ * The stage is kept as it was, so the reset record shows what kept failing
  */
 void Watchdog::resetNow() const {
     DEBUG(Serial.printf(F("Watchdog rebooting after %u failures\n"), errors));
-    delay(1000);
+    resetMarker = ERROR_LIMIT_MARKER;
+    reboot();
+}
+
+/**
+ * Reboot through the reset supervisor, such as when asked to from the debug console
+ * The WDT is fed until then, so the reset is recorded as EXTERNAL rather than LOOP_WATCHDOG
+ * It stays armed, if the supervisor never resets the MCU the WDT still does
+ */
+void Watchdog::reboot() {
+    for (uint16_t waited = 0; waited < WATCHDOG_REBOOT_DELAY_MS; waited += WATCHDOG_REBOOT_FEED_MS) {
+        wdt_reset();
+        delay(WATCHDOG_REBOOT_FEED_MS);
+    }
+
+    wdt_reset();
 
     // When this pin is brought LOW it will trigger the reset supervisor IC
     // Not directly writing to RESET pin because it might not be held low long enough
     digitalWrite(SW_RESET, LOW);
 }
+
+/**
+ * Work out why the MCU reset, and persist it with the stage it happened in unless it was a power-on reset
+ * Power-on resets happen with every ignition cycle, recording them would soon overwrite the reset worth knowing about
+ * Flash must be loaded first
+ * @return the cause of this reset
+ */
+ResetCause Watchdog::logReset() {
+#ifdef HAL_NATIVE
+    resetFlags = MCUSR;
+#endif
+
+    ResetCause cause;
+
+    if (resetFlags & _BV(PORF)) {
+        cause = ResetCause::POWER_ON;
+    } else if (resetFlags & _BV(BORF)) {
+        cause = ResetCause::BROWN_OUT;
+    } else if (resetFlags & _BV(WDRF)) {
+        cause = ResetCause::LOOP_WATCHDOG;
+    } else if (resetMarker == ERROR_LIMIT_MARKER) {
+        cause = ResetCause::ERROR_LIMIT;
+    } else {
+        cause = ResetCause::EXTERNAL;
+    }
+
+    const ResetRecord& last = Flash::getResetRecord();
+
+    DEBUG(Serial.printf(
+        F("Reset cause=%u, recorded cause=%u stage=%u count=%u\n"),
+        static_cast<uint8_t>(cause),
+        last.cause,
+        last.stage,
+        last.count
+    ));
+
+    if (cause != ResetCause::POWER_ON) {
+        // RAM did not survive a brown-out, so neither did the stage
+        const WatchdogStage resetStage = cause == ResetCause::BROWN_OUT ? WatchdogStage::UNKNOWN : stage;
+
+        Flash::saveResetRecord({
+            static_cast<uint8_t>(cause),
+            static_cast<uint8_t>(resetStage),
+            static_cast<uint8_t>(last.count < UINT8_MAX ? last.count + 1 : UINT8_MAX)
+        });
+    }
+
+    resetMarker = 0;
+    return cause;
+}
+
+/**
+ * Record what the firmware is doing, costs a single store
+ * @param newStage the stage
+ */
+void Watchdog::enter(WatchdogStage const newStage) {
+    stage = newStage;
+}
+
+/**
+ * Start the hardware WDT, call when entering the main loop
+ */
+void Watchdog::supervise() {
+    wdt_enable(WATCHDOG_TIMEOUT);
+}
+
+/**
+ * Mark the start of a main loop iteration
+ */
+void Watchdog::startLoop() {
+    loopStart = Clock::now();
+}
+
+/**
+ * Mark the end of a main loop iteration's work, before it may sleep
+ * Feeds the WDT if the loop is healthy, an iteration over budget counts as an overrun
+ * A single overrun, such as a debug command, is tolerated, WATCHDOG_OVERRUN_LIMIT in a row stop the feeding
+ */
+void Watchdog::endLoop() {
+    const uint32_t busy = Clock::now() - loopStart;
+
+    if (busy > longestLoopMs) {
+        longestLoopMs = busy > UINT16_MAX ? UINT16_MAX : static_cast<uint16_t>(busy);
+    }
+
+    if (busy > WATCHDOG_LOOP_BUDGET_MS) {
+        overruns++;
+
+        if (overrunStreak < WATCHDOG_OVERRUN_LIMIT) {
+            overrunStreak++;
+        }
+    } else {
+        overrunStreak = 0;
+    }
+
+    feedIdle();
+}
+
+/**
+ * Feed the WDT while sleeping, only if the loop is healthy
+ * Sleeping is not a hang, the loop only sleeps once its work is done
+ * Called by Power::idle() each time the MCU wakes
+ */
+void Watchdog::feedIdle() {
+    if (overrunStreak < WATCHDOG_OVERRUN_LIMIT) {
+        wdt_reset();
+    }
+}
+
+/**
+ * Feed the WDT unconditionally, only for work which is known to take long
+ */
+void Watchdog::feed() {
+    wdt_reset();
+}
+
+/**
+ * Number of iterations over budget since the last clearStats()
+ * @return the count
+ */
+uint16_t Watchdog::getOverruns() {
+    return overruns;
+}
+
+/**
+ * Longest iteration since the last clearStats()
+ * @return busy time in ms
+ */
+uint16_t Watchdog::getLongestLoopMs() {
+    return longestLoopMs;
+}
+
+/**
+ * Reset the overrun count and longest iteration
+ */
+void Watchdog::clearStats() {
+    overruns = 0;
+    longestLoopMs = 0;
+}
@@ -2,12 +2,58 @@
 #define WATCHDOG_H
 
 #include <Arduino.h>
+#include <avr/wdt.h>
 
 #define SW_RESET 17
 
+// busy time of one main loop iteration, sleeping excluded, above which the iteration counts as an overrun
+#define WATCHDOG_LOOP_BUDGET_MS 50UL
+
+// consecutive overruns after which the hardware WDT is no longer fed, so it resets the MCU
+#define WATCHDOG_OVERRUN_LIMIT 3
+
+// hardware WDT timeout, the longest time the loop may go without being fed
+#define WATCHDOG_TIMEOUT WDTO_500MS
+
+// time serial output gets before the reset supervisor is triggered, see Watchdog::reboot()
+#define WATCHDOG_REBOOT_DELAY_MS 1000
+
+// the WDT is fed this often while waiting to reboot, well inside WATCHDOG_TIMEOUT
+#define WATCHDOG_REBOOT_FEED_MS 100
+
+/**
+ * Why the MCU reset, see Watchdog::logReset()
+ */
+enum class ResetCause : uint8_t {
+    POWER_ON,
+    EXTERNAL,      // reset pin, such as the reset supervisor after a debug console reboot
+    BROWN_OUT,
+    LOOP_WATCHDOG, // the hardware WDT, the main loop hung or kept overrunning its budget
+    ERROR_LIMIT,   // Watchdog::countError() hit its limit
+};
+
+/**
+ * What the firmware was doing, kept through a reset so its cause can be narrowed down
+ */
+enum class WatchdogStage : uint8_t {
+    BOOT,
+    CAN_INIT,
+    OLED_INIT,
+    READ_CAN,
+    DEBUG_INPUT,
+    RENDER,
+    COMMIT,
+    IDLE,
+    UNKNOWN = 0xFF, // RAM did not survive the reset
+};
+
 /**
  * Error handler watchdog
  * Reboots after its error recorder is invoked too many times
+ *
+ * Once the main loop runs, it is also supervised by the hardware WDT, see supervise()
+ * Each iteration's busy time is measured against WATCHDOG_LOOP_BUDGET_MS, the WDT is only fed while the loop is healthy
+ * The stage the firmware is in survives a reset, logReset() persists it with the reset cause
  */
 class Watchdog {
     /**
@@ -41,6 +87,69 @@ public:
      * Force an immediate reboot
      */
     void resetNow() const;
+
+    /**
+     * Reboot through the reset supervisor, such as when asked to from the debug console
+     * The WDT is fed until then, so the reset is recorded as EXTERNAL rather than LOOP_WATCHDOG
+     */
+    static void reboot();
+
+    /**
+     * Work out why the MCU reset, and persist it with the stage it happened in unless it was a power-on reset
+     * Flash must be loaded first
+     * @return the cause of this reset
+     */
+    static ResetCause logReset();
+
+    /**
+     * Record what the firmware is doing, costs a single store
+     * @param newStage the stage
+     */
+    static void enter(WatchdogStage newStage);
+
+    /**
+     * Start the hardware WDT, call when entering the main loop
+     */
+    static void supervise();
+
+    /**
+     * Mark the start of a main loop iteration
+     */
+    static void startLoop();
+
+    /**
+     * Mark the end of a main loop iteration's work, before it may sleep
+     * Feeds the WDT if the loop is healthy, an iteration over budget counts as an overrun
+     */
+    static void endLoop();
+
+    /**
+     * Feed the WDT while sleeping, only if the loop is healthy
+     * Called by Power::idle() each time the MCU wakes
+     */
+    static void feedIdle();
+
+    /**
+     * Feed the WDT unconditionally, only for work which is known to take long
+     */
+    static void feed();
+
+    /**
+     * Number of iterations over budget since the last clearStats()
+     * @return the count
+     */
+    [[nodiscard]] static uint16_t getOverruns();
+
+    /**
+     * Longest iteration since the last clearStats()
+     * @return busy time in ms
+     */
+    [[nodiscard]] static uint16_t getLongestLoopMs();
+
+    /**
+     * Reset the overrun count and longest iteration
+     */
+    static void clearStats();
 };
 
 #endif //WATCHDOG_H
@@ -0,0 +1,155 @@
+#ifndef HAL_NATIVE_ARDUINO_H
+#define HAL_NATIVE_ARDUINO_H
+
+/*
+ * Native stand-in for the parts of the Arduino AVR core the firmware uses
+ * Pins are plain memory, time comes from Clock, Serial is stdin/stdout
+ */
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <string.h>
+
+typedef uint8_t byte;
+
+#define HIGH 0x1
+#define LOW 0x0
+#define INPUT 0x0
+#define OUTPUT 0x1
+#define INPUT_PULLUP 0x2
+#define MSBFIRST 1
+
+// flash is ordinary memory on the host
+#define PROGMEM
+#define PSTR(s) (s)
+#define pgm_read_byte(addr) (*reinterpret_cast<const uint8_t*>(addr))
+#define pgm_read_word(addr) (*reinterpret_cast<const uint16_t*>(addr))
+#define pgm_read_dword(addr) (*reinterpret_cast<const uint32_t*>(addr))
+#define pgm_read_ptr(addr) (*reinterpret_cast<void* const*>(addr))
+#define memcpy_P memcpy
+#define strcpy_P strcpy
+#define strlen_P strlen
+#define strchr_P strchr
+#define snprintf_P snprintf
+
+class __FlashStringHelper;
+#define F(s) (reinterpret_cast<const __FlashStringHelper*>(s))
+
+#define _BV(bit) (1U << (bit))
+
+// there are no interrupts on the host, interrupt handlers are plain functions which are never called
+#define ISR(vector) void vector()
+
+// pin-change interrupt registers
+extern volatile uint8_t fakePcicr;
+extern volatile uint8_t fakePcmsk;
+#define digitalPinToPCICR(p) (&fakePcicr)
+#define digitalPinToPCICRbit(p) (0)
+#define digitalPinToPCMSK(p) (&fakePcmsk)
+#define digitalPinToPCMSKbit(p) (0)
+
+/**
+ * SPI data register, a write is sent at once
+ * If SPIE is set in SPCR, the transfer complete interrupt handler then runs, so background transfers finish immediately
+ */
+struct FakeSpiData {
+    FakeSpiData& operator=(uint8_t value);
+};
+
+// ADC control register, only ever switched off
+extern volatile uint8_t fakeAdcsra;
+#define ADCSRA fakeAdcsra
+#define ADEN 7
+
+// reset flags, the host always starts from power-on
+extern volatile uint8_t fakeMcusr;
+#define MCUSR fakeMcusr
+#define PORF 0
+#define EXTRF 1
+#define BORF 2
+#define WDRF 3
+
+// SPI registers
+extern volatile uint8_t fakeSpcr;
+extern FakeSpiData fakeSpdr;
+#define SPCR fakeSpcr
+#define SPDR fakeSpdr
+#define SPIE 7
+
+/**
+ * General purpose I/O register, only written by the firmware as its main loop marker
+ * Every write calls fakeLoopHook, which lets host tools run between loop iterations
+ */
+struct FakeLoopMarker {
+    FakeLoopMarker& operator=(uint8_t value);
+};
+
+extern FakeLoopMarker fakeGpior0;
+extern void (*fakeLoopHook)();
+#define GPIOR0 fakeGpior0
+
+/**
+ * Run the pin-change interrupt handler if it is enabled, as the board does when CAN_INT falls
+ */
+void fakePinChange();
+
+// number of fake pins
+#define NUM_DIGITAL_PINS 32
+
+uint32_t millis();
+uint32_t micros();
+void delay(uint32_t ms);
+void delayMicroseconds(uint16_t us);
+void pinMode(uint8_t pin, uint8_t mode);
+void digitalWrite(uint8_t pin, uint8_t value);
+int digitalRead(uint8_t pin);
+void noInterrupts();
+void interrupts();
+
+/**
+ * Output sink, matches the subset of Arduino's Print used by the firmware
+ */
+class Print {
+public:
+    virtual ~Print() = default;
+    virtual size_t write(uint8_t c) = 0;
+    size_t write(const char* str);
+    size_t write(const uint8_t* buffer, size_t size);
+};
+
+/**
+ * Serial port on stdin/stdout
+ */
+class HardwareSerial final : public Print {
+public:
+    /**
+     * Whether stdin is read, turned off when something else drives the program
+     */
+    bool input = true;
+
+    void begin(unsigned long baud);
+    int available();
+    int read();
+    int availableForWrite();
+    void flush();
+    size_t write(uint8_t c) override;
+    using Print::write;
+    size_t print(const char* str);
+    size_t print(const __FlashStringHelper* str);
+    size_t print(char c);
+    size_t print(long value, int base = 10);
+    size_t print(unsigned long value, int base = 10);
+    size_t print(int value, int base = 10);
+    size_t print(unsigned int value, int base = 10);
+    size_t println();
+    size_t println(const char* str);
+    size_t println(const __FlashStringHelper* str);
+    size_t printf(const char* format, ...);
+    size_t printf(const __FlashStringHelper* format, ...);
+    explicit operator bool() const;
+};
+
+extern HardwareSerial Serial;
+
+#endif //HAL_NATIVE_ARDUINO_H
@@ -0,0 +1,46 @@
+#ifndef HAL_NATIVE_EEPROM_H
+#define HAL_NATIVE_EEPROM_H
+
+#include <Arduino.h>
+
+// ATmega328P(B) EEPROM size
+#define FAKE_EEPROM_SIZE 1024
+
+/**
+ * EEPROM in memory, erased (0xFF) at start like a new chip
+ */
+class EEPROMClass {
+public:
+    uint8_t data[FAKE_EEPROM_SIZE];
+    uint32_t writes = 0;
+
+    EEPROMClass() {
+        memset(data, 0xFF, sizeof(data));
+    }
+
+    uint8_t read(int index) const {
+        return data[index];
+    }
+
+    void write(int index, uint8_t value) {
+        data[index] = value;
+        writes++;
+    }
+
+    void update(int index, uint8_t value) {
+        if (data[index] != value) {
+            write(index, value);
+        }
+    }
+
+    static constexpr uint16_t length() {
+        return FAKE_EEPROM_SIZE;
+    }
+};
+
+extern EEPROMClass EEPROM;
+
+// writes complete instantly on the host
+#define eeprom_is_ready() 1
+
+#endif //HAL_NATIVE_EEPROM_H
@@ -0,0 +1,467 @@
+/*
+ * Native implementations of the HAL stand-ins
+ * Only built by the native environment, see build_src_filter in platformio.ini
+ */
+
+#include <chrono>
+#include <cstdarg>
+#include <cstdlib>
+#include <poll.h>
+#include <unistd.h>
+
+#include <Arduino.h>
+#include <SPI.h>
+#include <EEPROM.h>
+#include <mcp_can.h>
+#include "../../Clock.h"
+#include "../../OLED.h"
+
+HardwareSerial Serial;
+SPIClass SPI;
+EEPROMClass EEPROM;
+
+volatile uint8_t fakePcicr = 0;
+volatile uint8_t fakePcmsk = 0;
+FakeLoopMarker fakeGpior0;
+volatile uint8_t fakeSpcr = 0;
+volatile uint8_t fakeAdcsra = 0;
+volatile uint8_t fakeMcusr = _BV(PORF);
+void (*fakeSleepHook)() = nullptr;
+FakeSpiData fakeSpdr;
+void (*fakeLoopHook)() = nullptr;
+
+// pin-change interrupt handler, in CanReceiver.cpp
+void PCINT1_vect();
+
+// SPI transfer complete interrupt handler, in PageFlusher.cpp
+void SPI_STC_vect();
+
+static uint8_t pinLevels[NUM_DIGITAL_PINS];
+static const auto startTime = std::chrono::steady_clock::now();
+
+// time
+
+static bool clockSet = false;
+static uint32_t clockNow = 0;
+
+/**
+ * Real milliseconds since the program started
+ * @return the time
+ */
+static uint32_t realMillis() {
+    return static_cast<uint32_t>(
+        std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - startTime).count()
+    );
+}
+
+uint32_t Clock::now() {
+    return clockSet ? clockNow : realMillis();
+}
+
+void Clock::set(uint32_t const ms) {
+    clockSet = true;
+    clockNow = ms;
+}
+
+void Clock::advance(uint32_t const ms) {
+    clockNow += ms;
+}
+
+uint32_t millis() {
+    return Clock::now();
+}
+
+/**
+ * Always real time, so benchmarks measure the host even while the clock is replaying
+ */
+uint32_t micros() {
+    return static_cast<uint32_t>(
+        std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - startTime).count()
+    );
+}
+
+void delay(uint32_t const ms) {
+    if (clockSet) {
+        Clock::advance(ms);
+    } else {
+        usleep(ms * 1000);
+    }
+}
+
+void delayMicroseconds(uint16_t const us) {
+    if (!clockSet) {
+        usleep(us);
+    }
+}
+
+// pins
+
+void pinMode(uint8_t const pin, uint8_t const mode) {
+    if (mode == INPUT_PULLUP && pin < NUM_DIGITAL_PINS) {
+        pinLevels[pin] = HIGH;
+    }
+}
+
+void digitalWrite(uint8_t const pin, uint8_t const value) {
+    if (pin < NUM_DIGITAL_PINS) {
+        pinLevels[pin] = value;
+    }
+}
+
+int digitalRead(uint8_t const pin) {
+    if (pin == FakeCan::interruptPin) {
+        FakeCanFrame frame;
+        return FakeCan::take(frame) ? LOW : HIGH;
+    }
+
+    return pin < NUM_DIGITAL_PINS ? pinLevels[pin] : LOW;
+}
+
+void noInterrupts() {}
+
+FakeLoopMarker& FakeLoopMarker::operator=(uint8_t) {
+    if (fakeLoopHook != nullptr) {
+        fakeLoopHook();
+    }
+
+    return *this;
+}
+
+FakeSpiData& FakeSpiData::operator=(uint8_t const value) {
+    static bool inInterrupt = false;
+    static bool pending = false;
+
+    SPI.bytesTransferred++;
+    FakeOled::receive(value);
+
+    if (!(fakeSpcr & _BV(SPIE))) {
+        return *this;
+    }
+
+    // the handler writes the next byte, run it in a loop rather than recursing once per byte
+    pending = true;
+
+    if (!inInterrupt) {
+        inInterrupt = true;
+
+        while (pending) {
+            pending = false;
+            SPI_STC_vect();
+        }
+
+        inInterrupt = false;
+    }
+
+    return *this;
+}
+
+void fakeSleep() {
+    if (fakeSleepHook != nullptr) {
+        fakeSleepHook();
+    } else {
+        delay(1);
+    }
+}
+
+void fakePinChange() {
+    if (fakePcicr && fakePcmsk) {
+        PCINT1_vect();
+    }
+}
+
+void interrupts() {}
+
+// serial
+
+size_t Print::write(const char* str) {
+    return write(reinterpret_cast<const uint8_t*>(str), strlen(str));
+}
+
+size_t Print::write(const uint8_t* buffer, size_t const size) {
+    for (size_t i = 0; i < size; i++) {
+        write(buffer[i]);
+    }
+
+    return size;
+}
+
+void HardwareSerial::begin(unsigned long) {}
+
+/**
+ * Check stdin without blocking
+ * The program ends when stdin is closed, so piped input can drive a run
+ */
+int HardwareSerial::available() {
+    if (!input) {
+        return 0;
+    }
+
+    pollfd fd = {STDIN_FILENO, POLLIN, 0};
+
+    if (poll(&fd, 1, 0) <= 0) {
+        return 0;
+    }
+
+    if (fd.revents & (POLLHUP | POLLERR) && !(fd.revents & POLLIN)) {
+        fflush(stdout);
+        exit(0);
+    }
+
+    return 1;
+}
+
+int HardwareSerial::read() {
+    unsigned char c;
+
+    if (::read(STDIN_FILENO, &c, 1) != 1) {
+        fflush(stdout);
+        exit(0);
+    }
+
+    return c;
+}
+
+int HardwareSerial::availableForWrite() {
+    return 63;
+}
+
+void HardwareSerial::flush() {
+    fflush(stdout);
+}
+
+size_t HardwareSerial::write(uint8_t const c) {
+    putchar(c);
+    return 1;
+}
+
+size_t HardwareSerial::print(const char* str) {
+    return fputs(str, stdout) >= 0 ? strlen(str) : 0;
+}
+
+size_t HardwareSerial::print(const __FlashStringHelper* str) {
+    return print(reinterpret_cast<const char*>(str));
+}
+
+size_t HardwareSerial::print(char const c) {
+    return write(static_cast<uint8_t>(c));
+}
+
+size_t HardwareSerial::print(long const value, int const base) {
+    return base == 16 ? ::printf("%lx", value) : ::printf("%ld", value);
+}
+
+size_t HardwareSerial::print(unsigned long const value, int const base) {
+    return base == 16 ? ::printf("%lx", value) : ::printf("%lu", value);
+}
+
+size_t HardwareSerial::print(int const value, int const base) {
+    return print(static_cast<long>(value), base);
+}
+
+size_t HardwareSerial::print(unsigned int const value, int const base) {
+    return print(static_cast<unsigned long>(value), base);
+}
+
+size_t HardwareSerial::println() {
+    return print("\n");
+}
+
+size_t HardwareSerial::println(const char* str) {
+    return print(str) + println();
+}
+
+size_t HardwareSerial::println(const __FlashStringHelper* str) {
+    return print(str) + println();
+}
+
+size_t HardwareSerial::printf(const char* format, ...) {
+    va_list args;
+    va_start(args, format);
+    const int written = vprintf(format, args);
+    va_end(args);
+    return written > 0 ? written : 0;
+}
+
+size_t HardwareSerial::printf(const __FlashStringHelper* format, ...) {
+    va_list args;
+    va_start(args, format);
+    const int written = vprintf(reinterpret_cast<const char*>(format), args);
+    va_end(args);
+    return written > 0 ? written : 0;
+}
+
+HardwareSerial::operator bool() const {
+    return true;
+}
+
+// CAN controller
+
+uint8_t FakeCan::interruptPin = 0xFF;
+uint8_t FakeCan::eflg = 0;
+uint8_t FakeCan::rxErrors = 0;
+uint8_t FakeCan::txErrors = 0;
+
+static FakeCanFrame rxBuffers[FAKE_CAN_RX_BUFFERS];
+static uint8_t rxWaiting = 0;
+
+bool FakeCan::inject(uint32_t const canId, uint8_t const len, const uint8_t* buf) {
+    if (rxWaiting >= FAKE_CAN_RX_BUFFERS) {
+        eflg |= rxWaiting == 1 ? MCP_EFLG_RX0OVR : MCP_EFLG_RX1OVR;
+        return false;
+    }
+
+    FakeCanFrame& frame = rxBuffers[rxWaiting++];
+    frame.canId = canId;
+    frame.len = len > 8 ? 8 : len;
+    memcpy(frame.buf, buf, frame.len);
+    return true;
+}
+
+bool FakeCan::take(FakeCanFrame& frame) {
+    if (rxWaiting == 0) {
+        return false;
+    }
+
+    frame = rxBuffers[0];
+    return true;
+}
+
+uint8_t MCP_CAN::readMsgBuf(uint32_t* id, uint8_t* len, uint8_t* buf) {
+    FakeCanFrame frame;
+
+    if (!FakeCan::take(frame)) {
+        return CAN_NOMSG;
+    }
+
+    // shift the second buffer down, like reading RXB0 before RXB1
+    rxBuffers[0] = rxBuffers[1];
+    rxWaiting--;
+
+    // mcp_can flags extended frames in the high bit
+    *id = frame.canId | 0x80000000UL;
+    *len = frame.len;
+    memcpy(buf, frame.buf, frame.len);
+    return CAN_OK;
+}
+
+uint8_t MCP_CAN::checkReceive() {
+    return rxWaiting > 0 ? CAN_MSGAVAIL : CAN_NOMSG;
+}
+
+uint8_t MCP_CAN::checkError() {
+    return FakeCan::eflg & (MCP_EFLG_RX1OVR | MCP_EFLG_RX0OVR | MCP_EFLG_TXBO | MCP_EFLG_TXEP | MCP_EFLG_RXEP)
+        ? CAN_CTRLERROR
+        : CAN_OK;
+}
+
+uint8_t MCP_CAN::getError() {
+    const uint8_t flags = FakeCan::eflg;
+    FakeCan::eflg &= ~(MCP_EFLG_RX0OVR | MCP_EFLG_RX1OVR);
+    return flags;
+}
+
+// display
+
+uint8_t FakeOled::csPin = 0xFF;
+uint8_t FakeOled::dcPin = 0xFF;
+uint8_t FakeOled::ram[FAKE_OLED_PAGES][FAKE_OLED_COLUMNS];
+bool FakeOled::displayOn = false;
+uint32_t FakeOled::commandBytes = 0;
+uint32_t FakeOled::dataBytes = 0;
+
+// addressing window and position, horizontal addressing mode
+static uint8_t oledColumnStart = 0;
+static uint8_t oledColumnEnd = FAKE_OLED_COLUMNS - 1;
+static uint8_t oledPageStart = 0;
+static uint8_t oledPageEnd = FAKE_OLED_PAGES - 1;
+static uint8_t oledColumn = 0;
+static uint8_t oledPage = 0;
+
+// command being assembled
+static uint8_t oledCommand = 0;
+static uint8_t oledParamsLeft = 0;
+static uint8_t oledParamIndex = 0;
+
+/**
+ * Number of parameter bytes following a command, only commands the firmware sends are listed
+ * @param command the command
+ * @return the count
+ */
+static uint8_t oledParamCount(uint8_t const command) {
+    switch (command) {
+        case SSD1306_COLUMNADDR:
+        case SSD1306_PAGEADDR:
+            return 2;
+        case SSD1306_MEMORYMODE:
+        case SSD1306_SETCONTRAST:
+        case SSD1306_CHARGEPUMP:
+        case SSD1306_SETMULTIPLEX:
+        case SSD1306_SETDISPLAYOFFSET:
+        case SSD1306_SETDISPLAYCLOCKDIV:
+        case SSD1306_SETPRECHARGE:
+        case SSD1306_SETCOMPINS:
+        case SSD1306_SETVCOMDETECT:
+            return 1;
+        default:
+            return 0;
+    }
+}
+
+/**
+ * Apply one parameter byte of the current command
+ * @param value the byte
+ */
+static void oledParam(uint8_t const value) {
+    if (oledCommand == SSD1306_COLUMNADDR) {
+        if (oledParamIndex == 0) {
+            oledColumnStart = oledColumn = value & (FAKE_OLED_COLUMNS - 1);
+        } else {
+            oledColumnEnd = value & (FAKE_OLED_COLUMNS - 1);
+        }
+    } else if (oledCommand == SSD1306_PAGEADDR) {
+        if (oledParamIndex == 0) {
+            oledPageStart = oledPage = value & (FAKE_OLED_PAGES - 1);
+        } else {
+            oledPageEnd = value & (FAKE_OLED_PAGES - 1);
+        }
+    }
+
+    oledParamIndex++;
+}
+
+void FakeOled::receive(uint8_t const value) {
+    if (csPin >= NUM_DIGITAL_PINS || pinLevels[csPin] != LOW) {
+        return;
+    }
+
+    if (pinLevels[dcPin] == LOW) {
+        commandBytes++;
+
+        if (oledParamsLeft > 0) {
+            oledParamsLeft--;
+            oledParam(value);
+            return;
+        }
+
+        oledCommand = value;
+        oledParamIndex = 0;
+        oledParamsLeft = oledParamCount(value);
+
+        if (value == SSD1306_DISPLAYON || value == SSD1306_DISPLAYOFF) {
+            displayOn = value == SSD1306_DISPLAYON;
+        }
+
+        return;
+    }
+
+    dataBytes++;
+    ram[oledPage][oledColumn] = value;
+
+    // horizontal addressing, wraps within the window
+    if (oledColumn >= oledColumnEnd) {
+        oledColumn = oledColumnStart;
+        oledPage = oledPage >= oledPageEnd ? oledPageStart : oledPage + 1;
+    } else {
+        oledColumn++;
+    }
+}
@@ -0,0 +1,119 @@
+/*
+ * Native entrypoint, runs the firmware as a host program
+ * Only built by the native environment, see build_src_filter in platformio.ini
+ *
+ * usage: program [--eeprom file] [--replay candump.log [--realtime] [--frames file] [--tick ms] [--late ms] [--verbose]]
+ * Without --replay, Serial is stdin/stdout, so the debug commands in Debug.cpp drive it
+ * With --replay, the log drives it, see Replay.h
+ * With --eeprom, EEPROM is loaded from the file and saved back on exit, so runs follow each other like power-ups
+ * Test builds (PIO_UNIT_TESTING) bring their own main(), see test/
+ */
+
+#ifndef PIO_UNIT_TESTING
+
+#include <cstdlib>
+
+#include <Arduino.h>
+#include <EEPROM.h>
+#include <mcp_can.h>
+#include <SPI.h>
+
+#include "Replay.h"
+
+// must match CAN_INT in main.cpp
+static constexpr uint8_t FAKE_CAN_INT = 16;
+
+// must match SPI_CS_PIN_OLED and OLED_DC in main.cpp
+static constexpr uint8_t FAKE_OLED_CS = 2;
+static constexpr uint8_t FAKE_OLED_DC = 4;
+
+// firmware entrypoint, in main.cpp
+[[noreturn]] void setup();
+
+/**
+ * Print usage and exit
+ * @param name program name
+ */
+[[noreturn]] static void usage(const char *name) {
+    fprintf(stderr, "usage: %s [--eeprom file] [--replay candump.log [--realtime] [--frames file] [--tick ms] [--late ms] [--verbose]]\n", name);
+    exit(2);
+}
+
+// file EEPROM is kept in, or nullptr
+static const char *eepromPath = nullptr;
+
+/**
+ * Load EEPROM from eepromPath, a missing file leaves it erased like a new chip
+ */
+static void loadEeprom() {
+    FILE *file = fopen(eepromPath, "rb");
+
+    if (file == nullptr) {
+        return;
+    }
+
+    if (fread(EEPROM.data, 1, sizeof(EEPROM.data), file) != sizeof(EEPROM.data)) {
+        fprintf(stderr, "%s is not a %u byte EEPROM image\n", eepromPath, FAKE_EEPROM_SIZE);
+        exit(2);
+    }
+
+    fclose(file);
+}
+
+/**
+ * Save EEPROM to eepromPath, run on exit
+ */
+static void saveEeprom() {
+    FILE *file = fopen(eepromPath, "wb");
+
+    if (file == nullptr || fwrite(EEPROM.data, 1, sizeof(EEPROM.data), file) != sizeof(EEPROM.data)) {
+        perror(eepromPath);
+    }
+
+    if (file != nullptr) {
+        fclose(file);
+    }
+}
+
+int main(int argc, char *argv[]) {
+    setvbuf(stdout, nullptr, _IOLBF, 0);
+    FakeCan::interruptPin = FAKE_CAN_INT;
+    FakeOled::csPin = FAKE_OLED_CS;
+    FakeOled::dcPin = FAKE_OLED_DC;
+
+    ReplayOptions options;
+
+    for (int i = 1; i < argc; i++) {
+        const bool hasValue = i + 1 < argc;
+
+        if (!strcmp(argv[i], "--eeprom") && hasValue) {
+            eepromPath = argv[++i];
+        } else if (!strcmp(argv[i], "--replay") && hasValue) {
+            options.log = argv[++i];
+        } else if (!strcmp(argv[i], "--realtime")) {
+            options.realtime = true;
+        } else if (!strcmp(argv[i], "--frames") && hasValue) {
+            options.framesPath = argv[++i];
+        } else if (!strcmp(argv[i], "--tick") && hasValue) {
+            options.tickMs = static_cast<uint32_t>(strtoul(argv[++i], nullptr, 10));
+        } else if (!strcmp(argv[i], "--late") && hasValue) {
+            options.lateMs = static_cast<uint32_t>(strtoul(argv[++i], nullptr, 10));
+        } else if (!strcmp(argv[i], "--verbose")) {
+            options.verbose = true;
+        } else {
+            usage(argv[0]);
+        }
+    }
+
+    if (eepromPath != nullptr) {
+        loadEeprom();
+        atexit(saveEeprom);
+    }
+
+    if (options.log != nullptr) {
+        Replay::begin(options);
+    }
+
+    setup();
+}
+#endif
@@ -0,0 +1,376 @@
+/*
+ * Replay engine for the native environment, see Replay.h
+ * Only built by the native environment, see build_src_filter in platformio.ini
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <thread>
+#include <vector>
+
+#include <Arduino.h>
+#include <mcp_can.h>
+#include <SPI.h>
+#include <avr/sleep.h>
+
+#include "Replay.h"
+#include "../../Clock.h"
+#include "../../CanReceiver.h"
+#include "../../Debug.h"
+#include "../../GMLan.h"
+#include "../../OLED.h"
+#include "../../Pipeline.h"
+
+// replay continues this long after the last frame, so timeouts and blinks play out
+static constexpr uint32_t REPLAY_TAIL_MS = 3000;
+
+// framebuffer size
+static constexpr size_t FRAMEBUFFER_SIZE = SCREEN_WIDTH * OLED_PAGES;
+
+/**
+ * A recorded frame
+ */
+struct ReplayFrame {
+    uint32_t ms;
+    uint32_t canId;
+    uint8_t len;
+    uint8_t buf[8];
+};
+
+/**
+ * A changed value waiting to be seen on the display
+ */
+struct ReplayPending {
+    uint32_t arbId;
+    uint32_t at;
+};
+
+/**
+ * Running minimum, maximum and average
+ */
+struct ReplayStat {
+    uint32_t count = 0;
+    uint64_t sum = 0;
+    uint32_t min = 0;
+    uint32_t max = 0;
+
+    void add(uint32_t const value) {
+        if (count == 0 || value < min) {
+            min = value;
+        }
+
+        if (value > max) {
+            max = value;
+        }
+
+        count++;
+        sum += value;
+    }
+};
+
+static ReplayOptions options;
+static std::vector<ReplayFrame> frames;
+static size_t nextFrame = 0;
+static bool started = false;
+static uint32_t baseMs = 0;
+static std::chrono::steady_clock::time_point wallStart;
+static FILE *framesFile = nullptr;
+
+static uint8_t shown[FRAMEBUFFER_SIZE];
+static std::vector<ReplayFrame> lastValues;
+static std::vector<ReplayPending> pending;
+
+static uint32_t injected = 0;
+static uint32_t filtered = 0;
+static uint32_t lostAtController = 0;
+static uint32_t late = 0;
+static uint32_t superseded = 0;
+static uint32_t framebufferChanges = 0;
+static ReplayStat latency;
+static ReplayStat loopsBetweenRenders;
+static uint32_t loopsSinceRender = 0;
+
+/**
+ * Read a candump log ("(seconds) iface ID#DATA"), timestamps are made relative to the earliest frame
+ * Remote frames are skipped
+ * @param path the log file
+ */
+static void loadLog(const char *path) {
+    FILE *file = fopen(path, "r");
+
+    if (file == nullptr) {
+        perror(path);
+        exit(2);
+    }
+
+    char line[256];
+    std::vector<double> times;
+
+    while (fgets(line, sizeof(line), file)) {
+        double seconds;
+        char text[64];
+
+        if (sscanf(line, " (%lf) %*s %63s", &seconds, text) != 2) {
+            continue;
+        }
+
+        char *hash = strchr(text, '#');
+
+        if (hash == nullptr || hash[1] == 'R') {
+            continue;
+        }
+
+        *hash = '\0';
+
+        ReplayFrame frame = {};
+        frame.canId = static_cast<uint32_t>(strtoul(text, nullptr, 16));
+
+        // standard frames would never pass the controller filters
+        if (strlen(text) <= 3) {
+            filtered++;
+            continue;
+        }
+
+        for (const char *data = hash + 1; data[0] && data[1] && frame.len < 8; data += 2) {
+            const char byte[3] = {data[0], data[1], '\0'};
+            frame.buf[frame.len++] = static_cast<uint8_t>(strtoul(byte, nullptr, 16));
+        }
+
+        times.push_back(seconds);
+        frames.push_back(frame);
+    }
+
+    fclose(file);
+
+    // logs merged from several interfaces are not always in order
+    const double first = times.empty() ? 0 : *std::min_element(times.begin(), times.end());
+
+    for (size_t i = 0; i < frames.size(); i++) {
+        frames[i].ms = static_cast<uint32_t>((times[i] - first) * 1000.0 + 0.5);
+    }
+
+    std::stable_sort(frames.begin(), frames.end(), [](const ReplayFrame& a, const ReplayFrame& b) {
+        return a.ms < b.ms;
+    });
+}
+
+/**
+ * Whether a frame's data differs from the previous frame with the same ARB ID
+ * @param frame the frame
+ * @return whether it changed
+ */
+static bool valueChanged(const ReplayFrame& frame) {
+    for (auto& last : lastValues) {
+        if (GMLAN_ARB(last.canId) == GMLAN_ARB(frame.canId)) {
+            const bool changed = last.len != frame.len || memcmp(last.buf, frame.buf, frame.len) != 0;
+            last = frame;
+            return changed;
+        }
+    }
+
+    lastValues.push_back(frame);
+    return true;
+}
+
+/**
+ * Put a frame on the bus, the controller raises CAN_INT and the interrupt reads it
+ * Frames the controller filters would drop are not injected
+ * @param frame the frame
+ */
+static void inject(const ReplayFrame& frame) {
+    if (GMLanRegistry::consumersOf(GMLAN_ARB(frame.canId)) == 0) {
+        filtered++;
+        return;
+    }
+
+    injected++;
+
+    if (!FakeCan::inject(frame.canId, frame.len, frame.buf)) {
+        lostAtController++;
+    }
+
+    fakePinChange();
+
+    if (!valueChanged(frame)) {
+        return;
+    }
+
+    // renderers only promise to show the newest value, one which would not change the display may never be drawn
+    for (auto& value : pending) {
+        if (value.arbId == GMLAN_ARB(frame.canId)) {
+            value.at = Clock::now();
+            superseded++;
+            return;
+        }
+    }
+
+    pending.push_back({GMLAN_ARB(frame.canId), Clock::now()});
+}
+
+/**
+ * Write the framebuffer as text, one character per pixel
+ * @param buffer the framebuffer
+ */
+static void writeFrame(const uint8_t *buffer) {
+    fprintf(framesFile, "@%lu\n", static_cast<unsigned long>(Clock::now() - baseMs));
+
+    for (uint8_t y = 0; y < SCREEN_HEIGHT; y++) {
+        for (uint8_t x = 0; x < SCREEN_WIDTH; x++) {
+            fputc(buffer[x + (y / OLED_PAGE_HEIGHT) * SCREEN_WIDTH] & _BV(y % OLED_PAGE_HEIGHT) ? '#' : '.', framesFile);
+        }
+
+        fputc('\n', framesFile);
+    }
+}
+
+/**
+ * Compare what the panel shows with what was last seen, a change shows the newest pending value of every ARB ID
+ */
+static void checkFramebuffer() {
+    // the module shows the first pages of display RAM, which are stored one after the other
+    const uint8_t *buffer = FakeOled::ram[0];
+
+    if (memcmp(buffer, shown, FRAMEBUFFER_SIZE) == 0) {
+        return;
+    }
+
+    memcpy(shown, buffer, FRAMEBUFFER_SIZE);
+    framebufferChanges++;
+    loopsBetweenRenders.add(loopsSinceRender);
+    loopsSinceRender = 0;
+
+    for (const auto& value : pending) {
+        const uint32_t waited = Clock::now() - value.at;
+        latency.add(waited);
+
+        if (waited > options.lateMs) {
+            late++;
+        }
+    }
+
+    pending.clear();
+
+    if (framesFile != nullptr) {
+        writeFrame(buffer);
+    }
+}
+
+/**
+ * Runs before every main loop iteration
+ * The framebuffer is checked first, so changes are timed to the iteration which drew them
+ */
+void Replay::tick() {
+    if (!started) {
+        started = true;
+        baseMs = Clock::now();
+        wallStart = std::chrono::steady_clock::now();
+    } else {
+        loopsSinceRender++;
+        checkFramebuffer();
+        Clock::advance(options.tickMs);
+    }
+
+    injectDue();
+}
+
+/**
+ * Runs every time the firmware sleeps, one tick passes without a loop iteration
+ */
+void Replay::sleep() {
+    checkFramebuffer();
+    Clock::advance(options.tickMs);
+    injectDue();
+}
+
+/**
+ * Inject the frames whose time was reached, and finish once the log is done
+ */
+void Replay::injectDue() {
+    const uint32_t elapsed = Clock::now() - baseMs;
+
+    while (nextFrame < frames.size() && frames[nextFrame].ms <= elapsed) {
+        inject(frames[nextFrame++]);
+    }
+
+    if (nextFrame == frames.size() && elapsed >= (frames.empty() ? 0 : frames.back().ms) + REPLAY_TAIL_MS) {
+        finish();
+    }
+
+    if (options.realtime) {
+        std::this_thread::sleep_until(wallStart + std::chrono::milliseconds(elapsed));
+    }
+}
+
+/**
+ * Print statistics and exit
+ * Exits with 1 if any frame was dropped, or any changed value was late
+ */
+void Replay::finish() {
+    const uint16_t dropped = CanReceiver::getDroppedFrames();
+    const uint16_t overflows = CanReceiver::getControllerOverflows();
+    const auto wallMs = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - wallStart).count();
+
+    if (framesFile != nullptr) {
+        fclose(framesFile);
+    }
+
+    printf("replayed %lu ms in %lld ms\n", static_cast<unsigned long>(Clock::now() - baseMs), static_cast<long long>(wallMs));
+    printf("frames: %lu injected, %lu filtered\n", static_cast<unsigned long>(injected), static_cast<unsigned long>(filtered));
+    printf(
+        "lost: %lu at controller, %u controller overflows, %u ring drops\n",
+        static_cast<unsigned long>(lostAtController),
+        overflows,
+        dropped
+    );
+    printf(
+        "framebuffer changes: %lu, loops between changes min %lu max %lu\n",
+        static_cast<unsigned long>(framebufferChanges),
+        static_cast<unsigned long>(loopsBetweenRenders.min),
+        static_cast<unsigned long>(loopsBetweenRenders.max)
+    );
+
+    if (latency.count > 0) {
+        printf(
+            "value-to-pixel latency: %lu samples, min %lu ms, avg %.1f ms, max %lu ms, %lu over %lu ms\n",
+            static_cast<unsigned long>(latency.count),
+            static_cast<unsigned long>(latency.min),
+            static_cast<double>(latency.sum) / latency.count,
+            static_cast<unsigned long>(latency.max),
+            static_cast<unsigned long>(late),
+            static_cast<unsigned long>(options.lateMs)
+        );
+    }
+
+    printf("stale frames skipped: %u\n", getStaleFrames());
+    printf("changed values superseded before shown: %lu\n", static_cast<unsigned long>(superseded));
+    printf("changed values never shown: %lu\n", static_cast<unsigned long>(pending.size()));
+    printf("OLED SPI bytes: %lu\n", static_cast<unsigned long>(SPI.bytesTransferred));
+
+    exit(lostAtController > 0 || dropped > 0 || overflows > 0 || late > 0 ? 1 : 0);
+}
+
+/**
+ * Load the log and hook into the main loop
+ * Must be called before setup(), so boot also runs on the virtual clock
+ * @param replayOptions the replay options
+ */
+void Replay::begin(const ReplayOptions& replayOptions) {
+    options = replayOptions;
+    loadLog(options.log);
+
+    if (options.framesPath != nullptr) {
+        framesFile = fopen(options.framesPath, "w");
+
+        if (framesFile == nullptr) {
+            perror(options.framesPath);
+            exit(2);
+        }
+    }
+
+    Clock::set(0);
+    Serial.input = false;
+    Debug::muted = !options.verbose;
+    fakeLoopHook = tick;
+    fakeSleepHook = sleep;
+}
@@ -0,0 +1,77 @@
+#ifndef HAL_NATIVE_REPLAY_H
+#define HAL_NATIVE_REPLAY_H
+
+#include <Arduino.h>
+
+/**
+ * Options for a replay, see NativeMain.cpp for the matching command line
+ */
+struct ReplayOptions {
+    /**
+     * candump log to replay
+     */
+    const char *log = nullptr;
+
+    /**
+     * Keep virtual time in step with real time, otherwise run as fast as possible
+     */
+    bool realtime = false;
+
+    /**
+     * File for the framebuffer sequence, or nullptr
+     */
+    const char *framesPath = nullptr;
+
+    /**
+     * Virtual milliseconds each main loop iteration takes
+     */
+    uint32_t tickMs = 1;
+
+    /**
+     * A changed value shown later than this counts as late
+     */
+    uint32_t lateMs = 100;
+
+    /**
+     * Keep DEBUG() output
+     */
+    bool verbose = false;
+};
+
+/**
+ * Replays a candump log through the firmware on a virtual clock
+ * Runs between main loop iterations, so frames go through the same interrupt, ring, readCanBus() and renderers
+ * Each iteration, and each sleep, moves the clock forward by tickMs, and frames are injected once their time is reached
+ * When the log ends, statistics are printed and the program exits, unsuccessfully if anything was dropped or late
+ */
+class Replay {
+    /**
+     * Runs before every main loop iteration
+     */
+    static void tick();
+
+    /**
+     * Runs every time the firmware sleeps, one tick passes without a loop iteration
+     */
+    static void sleep();
+
+    /**
+     * Inject the frames whose time was reached, and finish once the log is done
+     */
+    static void injectDue();
+
+    /**
+     * Print statistics and exit
+     */
+    [[noreturn]] static void finish();
+
+public:
+    /**
+     * Load the log and hook into the main loop
+     * Must be called before setup(), so boot also runs on the virtual clock
+     * @param options the replay options
+     */
+    static void begin(const ReplayOptions& options);
+};
+
+#endif //HAL_NATIVE_REPLAY_H
@@ -0,0 +1,62 @@
+#ifndef HAL_NATIVE_SPI_H
+#define HAL_NATIVE_SPI_H
+
+#include <Arduino.h>
+
+#define SPI_MODE0 0x00
+
+/**
+ * SPI settings are accepted and ignored
+ */
+class SPISettings {
+public:
+    SPISettings() = default;
+    SPISettings(uint32_t, uint8_t, uint8_t) {}
+};
+
+// display RAM of the SSD1306, the 128x32 module only shows the first 4 pages
+#define FAKE_OLED_COLUMNS 128
+#define FAKE_OLED_PAGES 8
+
+/**
+ * SSD1306 on the bus, selected while its chip select pin is low
+ * Follows the command stream for addressing and keeps display RAM,
+ * so host tools see what is on the panel rather than what the firmware meant to send
+ */
+struct FakeOled {
+    static uint8_t csPin;
+    static uint8_t dcPin;
+    static uint8_t ram[FAKE_OLED_PAGES][FAKE_OLED_COLUMNS];
+    static bool displayOn;
+    static uint32_t commandBytes;
+    static uint32_t dataBytes;
+
+    /**
+     * Receive a byte from the bus, ignored unless selected
+     * @param value the byte
+     */
+    static void receive(uint8_t value);
+};
+
+/**
+ * SPI bus which only reaches FakeOled, counts bytes so benchmarks can report bus usage
+ */
+class SPIClass {
+public:
+    uint32_t bytesTransferred = 0;
+
+    void begin() {}
+    void beginTransaction(SPISettings) {}
+    void endTransaction() {}
+    void usingInterrupt(uint8_t) {}
+
+    uint8_t transfer(uint8_t value) {
+        bytesTransferred++;
+        FakeOled::receive(value);
+        return 0;
+    }
+};
+
+extern SPIClass SPI;
+
+#endif //HAL_NATIVE_SPI_H
@@ -0,0 +1,11 @@
+#ifndef HAL_NATIVE_AVR_POWER_H
+#define HAL_NATIVE_AVR_POWER_H
+
+// there is no power reduction register on the host
+#define power_adc_disable()
+#define power_twi_disable()
+#define power_timer1_disable()
+#define power_timer2_disable()
+#define power_usart0_disable()
+
+#endif //HAL_NATIVE_AVR_POWER_H
@@ -0,0 +1,21 @@
+#ifndef HAL_NATIVE_AVR_SLEEP_H
+#define HAL_NATIVE_AVR_SLEEP_H
+
+#include <Arduino.h>
+
+#define SLEEP_MODE_IDLE 0
+
+/**
+ * Sleeping lasts until the next interrupt, on the board that is at most one timer 0 tick
+ * Runs fakeSleepHook if set, so host tools can move time, otherwise waits one millisecond
+ */
+void fakeSleep();
+
+extern void (*fakeSleepHook)();
+
+#define set_sleep_mode(mode)
+#define sleep_enable()
+#define sleep_disable()
+#define sleep_cpu() fakeSleep()
+
+#endif //HAL_NATIVE_AVR_SLEEP_H
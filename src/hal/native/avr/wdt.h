@@ -0,0 +1,12 @@
+#ifndef HAL_NATIVE_AVR_WDT_H
+#define HAL_NATIVE_AVR_WDT_H
+
+// timeouts the firmware uses
+#define WDTO_500MS 5
+
+// there is nothing to hang on the host, so the WDT never fires
+#define wdt_enable(timeout)
+#define wdt_disable()
+#define wdt_reset()
+
+#endif //HAL_NATIVE_AVR_WDT_H
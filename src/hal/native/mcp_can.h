@@ -0,0 +1,132 @@
+#ifndef HAL_NATIVE_MCP_CAN_H
+#define HAL_NATIVE_MCP_CAN_H
+
+#include <Arduino.h>
+
+// subset of mcp_can_dfs.h
+#define CAN_OK 0
+#define CAN_FAILINIT 1
+#define CAN_MSGAVAIL 3
+#define CAN_NOMSG 4
+#define CAN_CTRLERROR 5
+#define MCP_STDEXT 0
+#define CAN_33K3BPS 3
+#define MCP_20MHZ 0
+#define MCP_16MHZ 1
+#define MCP_8MHZ 2
+#define MCP_LISTENONLY 0x60
+#define MCP_BITMOD 0x05
+#define MCP_EFLG 0x2D
+#define MCP_EFLG_RX1OVR (1 << 7)
+#define MCP_EFLG_RX0OVR (1 << 6)
+#define MCP_EFLG_TXBO (1 << 5)
+#define MCP_EFLG_TXEP (1 << 4)
+#define MCP_EFLG_RXEP (1 << 3)
+#define MCP_EFLG_TXWAR (1 << 2)
+#define MCP_EFLG_RXWAR (1 << 1)
+#define MCP_EFLG_EWARN (1 << 0)
+
+// number of RX buffers in the MCP25625
+#define FAKE_CAN_RX_BUFFERS 2
+
+/**
+ * A frame waiting in the fake controller
+ */
+struct FakeCanFrame {
+    uint32_t canId;
+    uint8_t len;
+    uint8_t buf[8];
+};
+
+/**
+ * Fake MCP25625, shared by every MCP_CAN instance
+ * Like the real controller, it holds two frames, drops anything more and flags an RX overflow,
+ * and holds the interrupt pin low while a frame is waiting
+ */
+class FakeCan {
+public:
+    /**
+     * Pin the controller pulls low while a frame is waiting, must be set to CAN_INT by the native entrypoint
+     */
+    static uint8_t interruptPin;
+
+    /**
+     * Error flags, mirrors the EFLG register
+     */
+    static uint8_t eflg;
+
+    /**
+     * RX error counter, mirrors the REC register
+     */
+    static uint8_t rxErrors;
+
+    /**
+     * TX error counter, mirrors the TEC register
+     */
+    static uint8_t txErrors;
+
+    /**
+     * Receive a frame from the bus
+     * Filters are not applied, only inject frames which would pass them
+     * @param canId the 29-bit CAN ID
+     * @param len the length of the buffer data
+     * @param buf the buffer data
+     * @return false if both RX buffers were full and the frame was lost
+     */
+    static bool inject(uint32_t canId, uint8_t len, const uint8_t* buf);
+
+    /**
+     * Take the oldest waiting frame
+     * @param frame output for the frame
+     * @return false if no frame was waiting
+     */
+    static bool take(FakeCanFrame& frame);
+};
+
+/**
+ * Subset of the mcp_can library API, backed by FakeCan
+ */
+class MCP_CAN {
+public:
+    explicit MCP_CAN(uint8_t csPin) {}
+
+    uint8_t begin(uint8_t idMode, uint8_t speed, uint8_t clock) {
+        return CAN_OK;
+    }
+
+    uint8_t init_Mask(uint8_t num, uint8_t ext, uint32_t ulData) {
+        return CAN_OK;
+    }
+
+    uint8_t init_Filt(uint8_t num, uint8_t ext, uint32_t ulData) {
+        return CAN_OK;
+    }
+
+    uint8_t setMode(uint8_t opMode) {
+        return CAN_OK;
+    }
+
+    uint8_t readMsgBuf(uint32_t* id, uint8_t* len, uint8_t* buf);
+
+    uint8_t checkReceive();
+
+    uint8_t checkError();
+
+    /**
+     * Read EFLG
+     * The real RX overflow flags are cleared by a BIT MODIFY over SPI, which goes nowhere on the host,
+     * so reading clears them here instead
+     * @return the error flags
+     */
+    uint8_t getError();
+
+    uint8_t errorCountRX() {
+        return FakeCan::rxErrors;
+    }
+
+    uint8_t errorCountTX() {
+        return FakeCan::txErrors;
+    }
+};
+
+#endif //HAL_NATIVE_MCP_CAN_H
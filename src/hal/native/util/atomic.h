@@ -0,0 +1,8 @@
+#ifndef HAL_NATIVE_UTIL_ATOMIC_H
+#define HAL_NATIVE_UTIL_ATOMIC_H
+
+// there are no interrupts on the host, so every block is already atomic
+#define ATOMIC_RESTORESTATE 0
+#define ATOMIC_BLOCK(type) for (bool atomicOnce = true; atomicOnce; atomicOnce = false)
+
+#endif //HAL_NATIVE_UTIL_ATOMIC_H
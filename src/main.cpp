@@ -2,15 +2,18 @@
 #include "DataTypes.h" // include before others, especially mcp_can, to normalize data types
 #include <SPI.h>
 #include <mcp_can.h>
-#include <Adafruit_GFX.h>
-#include <Adafruit_SSD1306.h>
 
 #include "OLED.h"
+#include "StaticObject.h"
+#include "PageFlusher.h"
 #include "GMLan.h"
 #include "Flash.h"
-#include "Renderer.h"
+#include "Power.h"
+#include "CanReceiver.h"
+#include "Pipeline.h"
 #include "GMTemperature.h"
 #include "GMParkAssist.h"
+#include "BusMonitor.h"
 #include "Watchdog.h"
 #include "Debug.h"
 
@@ -42,26 +45,6 @@ constexpr uint8_t SPI_MOSI = 11;
 constexpr uint8_t SPI_MISO = 12;
 constexpr uint8_t SPI_SCK = 13;
 
-// CANBUS filter data
-struct CanMaskFilterData {
-    uint8_t ext = 0;
-    uint32_t ulData = 0x00000000;
-};
-
-constexpr CanMaskFilterData masks[2] = {
-    {1, 0x00FFE000},
-    {1, 0x00FFE000},
-};
-
-constexpr CanMaskFilterData filters[6] = {
-    {1, GMLAN_R_ARB(GMLAN_MSG_TEMPERATURE)},
-    {1, GMLAN_R_ARB(GMLAN_MSG_PARK_ASSIST)},
-    {1, GMLAN_R_ARB(GMLAN_MSG_CLUSTER_UNITS)},
-    {1, 0x00000000},
-    {1, 0x00000000},
-    {1, 0x00000000},
-};
-
 /**
  * Run initialization function, and evaluate its result
  * If enough errors happen, the MCUs on the board all get rebooted by the reset supervisor
@@ -112,8 +95,8 @@ void initializeCanBus(MCP_CAN* canBus, Watchdog* watchdog) {
 
     DEBUG(Serial.println(F("Setting MCP25625 masks and filters")));
 
-    for (uint8_t maskId = 0; maskId < 2; maskId++) {
-        auto mask = masks[maskId];
+    for (uint8_t maskId = 0; maskId < ARB_REGISTRY_MASKS; maskId++) {
+        auto mask = GMLanRegistry::mask(maskId);
 
         runWithWatchdog(
             watchdog,
@@ -128,11 +111,11 @@ void initializeCanBus(MCP_CAN* canBus, Watchdog* watchdog) {
             }
         );
 
-        const uint8_t filterStart = maskId == 0 ? 0 : 2;
-        const uint8_t filterEnd = maskId == 0 ? 2 : 6;
+        const uint8_t filterStart = GMLanRegistry::firstFilter(maskId);
+        const uint8_t filterEnd = GMLanRegistry::endFilter(maskId);
 
         for (uint8_t filterId = filterStart; filterId < filterEnd; filterId++) {
-            auto filter = filters[filterId];
+            auto filter = GMLanRegistry::filter(filterId);
 
             runWithWatchdog(
                 watchdog,
@@ -163,7 +146,7 @@ void initializeCanBus(MCP_CAN* canBus, Watchdog* watchdog) {
         }
     );
 
-    pinMode(CAN_INT, INPUT); // set up interrupt
+    CanReceiver::begin(canBus, SPI_CS_PIN_CAN, CAN_INT); // set up interrupt
 
     DEBUG(Serial.println(F("MCP25625 initialization complete")));
 }
@@ -171,115 +154,17 @@ void initializeCanBus(MCP_CAN* canBus, Watchdog* watchdog) {
 /**
  * OLED display setup
  * Will also blank out the display
- * @param display
- * @param watchdog
+ * @param flusher
  */
-void initializeOledDisplay(Adafruit_SSD1306* display, Watchdog* watchdog) {
+void initializeOledDisplay(PageFlusher* flusher) {
     DEBUG(Serial.println(F("Initializing SSD1306 OLED")));
 
-    runWithWatchdog(
-        watchdog,
-        [display] {
-            return display->begin(SSD1306_SWITCHCAPVCC);
-        },
-        true,
-        [](const bool errorCode) {
-            DEBUG(Serial.printf(F("SSD1306 OLED initialization error %u\n"), errorCode));
-        }
-    );
-
-    display->clearDisplay();
-    display->display();
+    flusher->begin(OLED_RST);
+    flusher->markAllDirty();
+    flusher->flush(FrameSource());
     DEBUG(Serial.println(F("SSD1306 OLED initialization complete")));
 }
 
-/**
- * If new data is available from the CANBUS, process it
- * CAN_INT is low if there is a new message in the queue on the CAN controller
- * @param canBus
- * @param renderers
- * @param numRenderers
- */
-void readCanBus(MCP_CAN* canBus, Renderer** renderers, const size_t numRenderers) {
-    if (!digitalRead(CAN_INT)) {
-        uint32_t canId;
-        uint8_t len;
-        uint8_t buf[8];
-
-        if (canBus->readMsgBuf(&canId, &len, buf) == CAN_NOMSG) {
-            return;
-        }
-
-        auto const arbId = GMLAN_ARB(canId);
-        DEBUG(Serial.printf(F("Checking ARB ID 0x%08lx\n"), arbId));
-
-        if (arbId == GMLAN_MSG_CLUSTER_UNITS) {
-            const uint8_t units = buf[0] & 0x0F;
-            DEBUG(Serial.printf(F("New cluster units: 0x%02x\n"), units));
-            Flash::saveUnits(units);
-
-            for (size_t i = 0; i < numRenderers; i++) {
-                renderers[i]->setUnits(units);
-            }
-        }
-
-        for (size_t i = 0; i < numRenderers; i++) {
-            if (renderers[i]->recognizesArbId(arbId)) {
-                DEBUG(Serial.printf(F("Processing via %s ARB ID 0x%08lx\n"), renderers[i]->getName(), arbId));
-                renderers[i]->processMessage(arbId, len, buf);
-            }
-        }
-    }
-}
-
-/**
- * Render data to display
- * @param display
- * @param renderers
- * @param numRenderers
- * @param lastRenderer
- */
-void renderDisplay(Adafruit_SSD1306* display, Renderer** renderers, const size_t numRenderers, Renderer*& lastRenderer) {
-    /*
-     * Render new data, based on priority, taking the first which "should render"
-     * It is always assumed that if a module "should render" that it has new data and must render now
-     */
-    for (size_t i = 0; i < numRenderers; i++) {
-        if (renderers[i]->shouldRender()) {
-            DEBUG(Serial.printf(F("Rendering [1] via %s\n"), renderers[i]->getName()));
-            renderers[i]->render();
-            lastRenderer = renderers[i];
-            return; // exit loop
-        }
-    }
-
-    /*
-     * Render old data, based on priority, taking the first which "can render"
-     * Only the first module which "can render" is considered, this avoids oscillation in display choice
-     */
-    for (size_t i = 0; i < numRenderers; i++) {
-        if (renderers[i]->canRender()) {
-            // if we just rendered, don't waste time re-rendering
-            if (lastRenderer == renderers[i]) {
-                return;
-            }
-
-            DEBUG(Serial.printf(F("Rendering [2] via %s\n"), renderers[i]->getName()));
-            renderers[i]->render();
-            lastRenderer = renderers[i];
-            return; // exit loop
-        }
-    }
-
-    if (lastRenderer != nullptr) {
-        /*
-         * If there is absolutely nothing that should or can be rendered, clear the display
-         */
-        display->clearDisplay();
-        display->display();
-    }
-}
-
 /**
  * Main entrypoint
  * Called by int main() by framework
@@ -287,40 +172,113 @@ void renderDisplay(Adafruit_SSD1306* display, Renderer** renderers, const size_t
 [[noreturn]] void setup() {
     DEBUG(Serial.begin(SER_BAUD));
     DEBUG(Serial.println(F("Booting up")));
-    const auto watchdog = new Watchdog();
+    Power::begin();
+
+    // the stage of the previous run is only kept until the first enter()
+    Flash::begin();
+    Watchdog::logReset();
+    Watchdog::enter(WatchdogStage::BOOT);
+
+    /*
+     * Every long-lived object lives in static storage, so RAM use is known at link time
+     * See scripts/check_ram_budget.py
+     */
+    static StaticObject<Watchdog> watchdogStorage;
+    static StaticObject<MCP_CAN> canBusStorage;
+    static StaticObject<PageFlusher> flusherStorage;
+    static StaticObject<GMParkAssist> parkAssistStorage;
+#if DO_DEBUG == 1
+    static StaticObject<BusDiagnostics> diagnosticsStorage;
+#endif
+    static StaticObject<GMTemperature> temperatureStorage;
+
+    const auto watchdog = watchdogStorage.create();
 
     delay(10);
 
-    const auto canBus = new MCP_CAN(SPI_CS_PIN_CAN);
-    initializeCanBus(canBus, watchdog);
+    // constructing the CAN controller deselects it, so the display can use the shared SPI bus before it is set up
+    const auto canBus = canBusStorage.create(SPI_CS_PIN_CAN);
 
-    const auto display = new Adafruit_SSD1306(SCREEN_WIDTH, SCREEN_HEIGHT, &SPI, OLED_DC, OLED_RST, SPI_CS_PIN_OLED, OLED_SPI_BAUD);
-    initializeOledDisplay(display, watchdog);
+    // the display comes first, so what it showed before power-off is back before the CAN controller is set up
+    Watchdog::enter(WatchdogStage::OLED_INIT);
+    const auto flusher = flusherStorage.create(OLED_DC, SPI_CS_PIN_OLED, OLED_SPI_BAUD);
+    initializeOledDisplay(flusher);
 
     /*
      * Set up Renderer objects
      * These objects both read/process GMLAN data and render to the display when called
-     * These should be stored in **renderers in order of priority, with most important renderer first
+     * They are handed to the pipeline in order of priority, with most important renderer first
+     * The order is fixed by GMLanRenderers, which GMLanRegistry and GMLAN_LAYOUTS follow
      */
 
     DEBUG(Serial.println(F("Preparing renderers")));
-    Flash::setDefaults();
     const auto units = Flash::getUnits();
+    const auto temperature = temperatureStorage.create(flusher, units);
+    temperature->restore(Flash::getTemperature(), Flash::getTemperatureAge());
+
+    GMLanRenderers renderers(
+        GMLAN_LAYOUTS,
+        GMLAN_LAYOUT_COUNT,
+        parkAssistStorage.create(flusher, units),
+#if DO_DEBUG == 1
+        diagnosticsStorage.create(flusher, units),
+#endif
+        temperature
+    );
+
+    // show the restored temperature, if any, while the CAN controller starts, live data replaces it
+    Watchdog::enter(WatchdogStage::RENDER);
+    flusher->wait();
+    renderDisplay(flusher, renderers);
+
+    // the CAN controller is set up without SpiBus, so the frame must be sent before
+    flusher->wait();
 
-    constexpr size_t numRenderers = 2;
-    Renderer *lastRenderer = nullptr; // last renderer to render, to avoid doubles of same data
-    Renderer* renderers[numRenderers];
-    renderers[0] = new GMParkAssist(display, units);
-    renderers[1] = new GMTemperature(display, units);
+    Watchdog::enter(WatchdogStage::CAN_INIT);
+    initializeCanBus(canBus, watchdog);
+
+#if DO_DEBUG == 1
+    // telemetry refers to renderers by index
+    uint8_t rendererIndex = 0;
+
+    renderers.forEach([&rendererIndex](auto& renderer) {
+        Serial.printf(F("Renderer %u is "), rendererIndex++);
+        Serial.println(renderer.getName());
+    });
+#endif
 
     DEBUG(Serial.println(F("Booted up")));
 
+    // from here on a hung or persistently slow loop resets the MCU, see Watchdog
+    Watchdog::supervise();
+
     // loop in setup to avoid global variables
     while (true) {
-        readCanBus(canBus, renderers, numRenderers);
-        renderDisplay(display, renderers, numRenderers, lastRenderer);
+        // marks a loop iteration, native builds run the replay there, see fakeLoopHook, costs one OUT instruction
+        GPIOR0 = 0;
+        Watchdog::startLoop();
+
+        Watchdog::enter(WatchdogStage::READ_CAN);
+        readCanBus(renderers);
+        BusMonitor::update();
+
+        // ahead of rendering, so what a command changed is drawn before the loop sleeps
+        Watchdog::enter(WatchdogStage::DEBUG_INPUT);
+        Debug::processDebugInput(flusher, renderers);
+
+        Watchdog::enter(WatchdogStage::RENDER);
+        renderDisplay(flusher, renderers);
 
-        Debug::processDebugInput(renderers, numRenderers);
+        Watchdog::enter(WatchdogStage::COMMIT);
+        Flash::commit();
+
+        Watchdog::endLoop();
+
+        // a transfer in flight or an EEPROM write ends without waking the loop, so only sleep once they are done
+        if (!flusher->isBusy() && !Flash::isCommitPending()) {
+            Watchdog::enter(WatchdogStage::IDLE);
+            Power::idle(renderers.getNextDeadline());
+        }
     }
 }
 
@@ -0,0 +1,246 @@
+/*
+ * Benchmarks of the hot paths, run on the host through the native HAL, see src/hal/native
+ * run with: pio test -e test -f test_benchmark -v
+ *
+ * Every case drives the real Pipeline and renderers, and reports its cost per frame on stdout and as test properties,
+ * so results can be compared between changes
+ * Costs are host time, only changes between runs mean anything, the asserts only check that the work was done
+ */
+
+#include <cstdio>
+#include <string>
+
+#include <gtest/gtest.h>
+
+#include <Arduino.h>
+#include <SPI.h>
+
+#include "Clock.h"
+#include "CanReceiver.h"
+#include "Debug.h"
+#include "GMLan.h"
+#include "PageFlusher.h"
+#include "Pipeline.h"
+#include "StaticObject.h"
+
+// number of frames each benchmark processes
+#define BENCHMARK_FRAMES 256
+
+// must match the pins and clock in main.cpp
+static constexpr uint8_t OLED_CS = 2;
+static constexpr uint8_t OLED_DC = 4;
+static constexpr uint8_t OLED_RST = 3;
+static constexpr uint32_t OLED_SPI_BAUD = 1000000UL;
+
+/**
+ * Print one result and record it as test properties
+ * @param name label for the result
+ * @param frames number of frames
+ * @param elapsed microseconds taken by all frames
+ * @param spiBytes SPI bytes sent for all frames
+ */
+static void report(const std::string& name, uint32_t const frames, uint32_t const elapsed, uint32_t const spiBytes) {
+    const double perFrame = static_cast<double>(elapsed) / frames;
+    const double bytesPerFrame = static_cast<double>(spiBytes) / frames;
+
+    printf("bench %s: %lu frames, %.3f us/frame, %.1f SPI bytes/frame\n",
+        name.c_str(), static_cast<unsigned long>(frames), perFrame, bytesPerFrame);
+
+    ::testing::Test::RecordProperty(name + " ns/frame", std::to_string(static_cast<long>(perFrame * 1000)));
+    ::testing::Test::RecordProperty(name + " SPI bytes/frame", std::to_string(static_cast<long>(bytesPerFrame)));
+}
+
+/**
+ * Renderers and the display, set up like main.cpp does, once for every case
+ */
+class Benchmark : public ::testing::Test {
+protected:
+    static PageFlusher* flusher;
+    static GMParkAssist* parkAssist;
+    static GMTemperature* temperature;
+    static GMLanRenderers* renderers;
+
+    static void SetUpTestSuite() {
+        static StaticObject<PageFlusher> flusherStorage;
+        static StaticObject<GMParkAssist> parkAssistStorage;
+#if DO_DEBUG == 1
+        static StaticObject<BusDiagnostics> diagnosticsStorage;
+#endif
+        static StaticObject<GMTemperature> temperatureStorage;
+        static StaticObject<GMLanRenderers> renderersStorage;
+
+        FakeOled::csPin = OLED_CS;
+        FakeOled::dcPin = OLED_DC;
+
+        // DEBUG() and TELEMETRY() output would be most of what is measured
+        Debug::muted = true;
+        Clock::set(1000);
+
+        flusher = flusherStorage.create(OLED_DC, OLED_CS, OLED_SPI_BAUD);
+        flusher->begin(OLED_RST);
+        flusher->markAllDirty();
+        flusher->flush(FrameSource());
+        flusher->wait();
+
+        parkAssist = parkAssistStorage.create(flusher, GMLAN_VAL_CLUSTER_UNITS_METRIC);
+        temperature = temperatureStorage.create(flusher, GMLAN_VAL_CLUSTER_UNITS_METRIC);
+
+        renderers = renderersStorage.create(
+            GMLAN_LAYOUTS,
+            GMLAN_LAYOUT_COUNT,
+            parkAssist,
+#if DO_DEBUG == 1
+            diagnosticsStorage.create(flusher, GMLAN_VAL_CLUSTER_UNITS_METRIC),
+#endif
+            temperature
+        );
+    }
+
+    void SetUp() override {
+        // a park assist frame from an earlier case must not hide the temperature
+        CanFrame off = {GMLAN_R_ARB(GMLAN_MSG_PARK_ASSIST), 8, {GMLAN_VAL_PARK_ASSIST_OFF, 0, 0, 0, 0, 0, 0, 0}};
+        processCanFrame(off, *renderers);
+        flusher->wait();
+    }
+
+    /**
+     * Time decoding and dispatching frames through processCanFrame()
+     * @param name label for the result
+     * @param arbId ARB ID of the frame
+     * @param payload first byte of frame data, the second byte is varied so values change
+     */
+    static void processFrames(const std::string& name, uint32_t const arbId, uint8_t const payload) {
+        CanFrame frame = {GMLAN_R_ARB(arbId), 8, {payload, 0, 0, 0, 0, 0, 0, 0}};
+        const uint32_t start = micros();
+
+        for (uint16_t i = 0; i < BENCHMARK_FRAMES; i++) {
+            frame.buf[1] = static_cast<uint8_t>(i | 1);
+            processCanFrame(frame, *renderers);
+        }
+
+        report(name, BENCHMARK_FRAMES, micros() - start, 0);
+    }
+
+    /**
+     * Whether any pixel is set on the visible part of the panel
+     * @return whether the panel shows anything
+     */
+    static bool isPanelLit() {
+        for (uint8_t page = 0; page < OLED_PAGES; page++) {
+            for (uint8_t column = 0; column < SCREEN_WIDTH; column++) {
+                if (FakeOled::ram[page][column] != 0) {
+                    return true;
+                }
+            }
+        }
+
+        return false;
+    }
+};
+
+PageFlusher* Benchmark::flusher = nullptr;
+GMParkAssist* Benchmark::parkAssist = nullptr;
+GMTemperature* Benchmark::temperature = nullptr;
+GMLanRenderers* Benchmark::renderers = nullptr;
+
+TEST_F(Benchmark, ProcessTemperatureFrames) {
+    processFrames("process temperature", GMLAN_MSG_TEMPERATURE, 0);
+    EXPECT_TRUE(temperature->canRender());
+}
+
+TEST_F(Benchmark, ProcessParkAssistFrames) {
+    processFrames("process park assist", GMLAN_MSG_PARK_ASSIST, GMLAN_VAL_PARK_ASSIST_ON);
+    EXPECT_TRUE(parkAssist->canRender());
+    EXPECT_NE(RENDERER_NO_DEADLINE, parkAssist->getNextDeadline());
+}
+
+TEST_F(Benchmark, ReadCanBusFullRing) {
+    CanFrame frame = {GMLAN_R_ARB(GMLAN_MSG_TEMPERATURE), 8, {0, 0, 0, 0, 0, 0, 0, 0}};
+    const uint16_t dropped = CanReceiver::getDroppedFrames();
+    uint32_t count = 0;
+    const uint32_t start = micros();
+
+    // the ring is filled before each read, the most readCanBus() can take in one loop
+    while (count < BENCHMARK_FRAMES) {
+        for (uint8_t i = 0; i < CanReceiver::capacity(); i++) {
+            frame.buf[1] = static_cast<uint8_t>(++count | 1);
+            CanReceiver::inject(frame);
+        }
+
+        readCanBus(*renderers);
+    }
+
+    report("readCanBus", count, micros() - start, 0);
+    EXPECT_EQ(dropped, CanReceiver::getDroppedFrames());
+}
+
+TEST_F(Benchmark, RenderEachRenderer) {
+    // every renderer gets something to show, an obstacle close behind, a temperature and the diagnostics page
+    CanFrame obstacle = {GMLAN_R_ARB(GMLAN_MSG_PARK_ASSIST), 8, {GMLAN_VAL_PARK_ASSIST_ON, 60, 0x22, 0, 0, 0, 0, 0}};
+    CanFrame reading = {GMLAN_R_ARB(GMLAN_MSG_TEMPERATURE), 8, {0, 130, 0, 0, 0, 0, 0, 0}};
+    processCanFrame(obstacle, *renderers);
+    processCanFrame(reading, *renderers);
+#if DO_DEBUG == 1
+    BusDiagnostics::setEnabled(true);
+#endif
+
+    // every render is followed by drawing and sending the whole display, the worst case for the bus
+    renderers->forEach([](auto& renderer) {
+        const std::string name = reinterpret_cast<const char*>(renderer.getName());
+
+        // a renderer with nothing to show would silently drop out of the results
+        ASSERT_TRUE(renderer.canRender()) << name;
+
+        uint32_t renderTime = 0;
+        uint32_t flushTime = 0;
+        const uint32_t bytes = SPI.bytesTransferred;
+
+        for (uint16_t i = 0; i < BENCHMARK_FRAMES; i++) {
+            renderer.invalidate();
+            const uint32_t start = micros();
+            renderer.render();
+            const uint32_t rendered = micros();
+            flusher->markAllDirty();
+            flusher->flush(FrameSource::of(renderer));
+            flusher->wait();
+            renderTime += rendered - start;
+            flushTime += micros() - rendered;
+        }
+
+        report(name + " render", BENCHMARK_FRAMES, renderTime, 0);
+        report(name + " flush", BENCHMARK_FRAMES, flushTime, SPI.bytesTransferred - bytes);
+        EXPECT_GT(SPI.bytesTransferred, bytes);
+    });
+
+#if DO_DEBUG == 1
+    BusDiagnostics::setEnabled(false);
+#endif
+
+    // the benchmark left its own drawing, the pipeline must draw everything again
+    renderers->invalidate();
+}
+
+TEST_F(Benchmark, FrameToPanel) {
+    CanFrame frame = {GMLAN_R_ARB(GMLAN_MSG_TEMPERATURE), 8, {0, 0, 0, 0, 0, 0, 0, 0}};
+    const uint32_t bytes = SPI.bytesTransferred;
+    const uint32_t start = micros();
+
+    // a new temperature every frame, each is received, rendered and sent like in the main loop
+    for (uint16_t i = 0; i < BENCHMARK_FRAMES; i++) {
+        frame.buf[1] = static_cast<uint8_t>(40 + i % 64 * 2);
+        CanReceiver::inject(frame);
+        readCanBus(*renderers);
+        renderDisplay(flusher, *renderers);
+        flusher->wait();
+        Clock::advance(1);
+    }
+
+    report("frame to panel", BENCHMARK_FRAMES, micros() - start, SPI.bytesTransferred - bytes);
+    EXPECT_GT(SPI.bytesTransferred, bytes);
+    EXPECT_TRUE(isPanelLit());
+}
+
+int main(int argc, char** argv) {
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,231 @@
+/*
+ * Checks that renderers draw the same frame whether it is built in a framebuffer or one page at a time
+ * run with: pio test -e test -e test_page -f test_page_canvas
+ *
+ * Both ways of building a frame run in one binary, PageFlusher only does the one OLED_PAGE_MODE selects,
+ * so the suite runs in both test and test_page, where the panel is also checked against the frame
+ */
+
+#include <cstring>
+
+#include <gtest/gtest.h>
+
+#include <Arduino.h>
+
+#include "Clock.h"
+#include "Debug.h"
+#include "GMLan.h"
+#include "GMParkAssist.h"
+#include "GMTemperature.h"
+#include "OLED.h"
+#include "PageCanvas.h"
+#include "PageFlusher.h"
+#include "Pipeline.h"
+#include "StaticObject.h"
+
+// must match the pins and clock in main.cpp
+static constexpr uint8_t OLED_CS = 2;
+static constexpr uint8_t OLED_DC = 4;
+static constexpr uint8_t OLED_RST = 3;
+static constexpr uint32_t OLED_SPI_BAUD = 1000000UL;
+
+// regions of GMLAN_LAYOUTS
+static constexpr Region FULL_SCREEN = {0, 0, SCREEN_WIDTH, SCREEN_HEIGHT};
+static constexpr Region BESIDE_SIDE_COLUMN = {0, 0, SCREEN_WIDTH - LAYOUT_SIDE_COLUMN_W, SCREEN_HEIGHT};
+static constexpr Region SIDE_COLUMN = {SCREEN_WIDTH - LAYOUT_SIDE_COLUMN_W, 0, LAYOUT_SIDE_COLUMN_W, SCREEN_HEIGHT};
+
+using Frame = uint8_t[OLED_PAGES][SCREEN_WIDTH];
+
+/**
+ * Build a frame in a framebuffer, each page drawn into its own row, as PageFlusher does without OLED_PAGE_MODE
+ * @param source the frame
+ * @param frame output
+ */
+static void drawFramebuffer(const FrameSource& source, Frame& frame) {
+    memset(frame, 0, sizeof(frame));
+
+    for (uint8_t page = 0; page < OLED_PAGES; page++) {
+        PageCanvas canvas(frame[page], page);
+        source.draw(canvas);
+    }
+}
+
+/**
+ * Build a frame one page at a time in a single row, as PageFlusher does with OLED_PAGE_MODE
+ * Each page is copied out before the row is cleared for the next
+ * @param source the frame
+ * @param frame output
+ */
+static void drawPageByPage(const FrameSource& source, Frame& frame) {
+    uint8_t row[SCREEN_WIDTH];
+
+    for (uint8_t page = 0; page < OLED_PAGES; page++) {
+        memset(row, 0, sizeof(row));
+        PageCanvas canvas(row, page);
+        source.draw(canvas);
+        memcpy(frame[page], row, sizeof(row));
+    }
+}
+
+/**
+ * Whether any pixel of a frame is set
+ * @param frame the frame
+ * @return whether it shows anything
+ */
+static bool isLit(const Frame& frame) {
+    for (uint8_t page = 0; page < OLED_PAGES; page++) {
+        for (uint8_t column = 0; column < SCREEN_WIDTH; column++) {
+            if (frame[page][column] != 0) {
+                return true;
+            }
+        }
+    }
+
+    return false;
+}
+
+/**
+ * The display, set up like main.cpp does, once for every case
+ * Each case draws renderers of its own, so no state carries over
+ */
+class PageCanvasTest : public ::testing::Test {
+protected:
+    static PageFlusher* flusher;
+
+    static void SetUpTestSuite() {
+        static StaticObject<PageFlusher> flusherStorage;
+
+        FakeOled::csPin = OLED_CS;
+        FakeOled::dcPin = OLED_DC;
+        Debug::muted = true;
+        Clock::set(1000);
+
+        flusher = flusherStorage.create(OLED_DC, OLED_CS, OLED_SPI_BAUD);
+        flusher->begin(OLED_RST);
+    }
+
+    /**
+     * Build a renderer's frame both ways and expect the same bytes, then send it and expect them on the panel
+     * @tparam Source renderer type
+     * @param source the renderer, placed and rendered
+     * @param state description of the state, for failures
+     */
+    template<typename Source>
+    static void expectSameFrame(const Source& source, const char* state) {
+        SCOPED_TRACE(state);
+        Frame framebuffer;
+        Frame pages;
+        const FrameSource frame = FrameSource::of(source);
+
+        drawFramebuffer(frame, framebuffer);
+        drawPageByPage(frame, pages);
+
+        ASSERT_TRUE(isLit(framebuffer));
+
+        for (uint8_t page = 0; page < OLED_PAGES; page++) {
+            EXPECT_EQ(0, memcmp(framebuffer[page], pages[page], SCREEN_WIDTH)) << "page " << unsigned(page);
+        }
+
+        // whichever way this build's PageFlusher builds it
+        flusher->markAllDirty();
+        flusher->flush(frame);
+        flusher->wait();
+
+        for (uint8_t page = 0; page < OLED_PAGES; page++) {
+            EXPECT_EQ(0, memcmp(framebuffer[page], FakeOled::ram[page], SCREEN_WIDTH))
+                << "panel page " << unsigned(page);
+        }
+    }
+
+    /**
+     * Show a temperature
+     * @param region where it is placed
+     * @param units GMLAN_VAL_CLUSTER_UNITS_*
+     * @param raw TEMPERATURE signal value
+     * @param state description of the state, for failures
+     */
+    static void expectTemperature(const Region& region, uint8_t const units, uint8_t const raw, const char* state) {
+        GMTemperature temperature(flusher, units);
+        uint8_t buf[8] = {0, raw, 0, 0, 0, 0, 0, 0};
+
+        temperature.place(region);
+        temperature.processMessage(GMLAN_MSG_TEMPERATURE, sizeof(buf), buf);
+        temperature.render();
+        expectSameFrame(temperature, state);
+    }
+
+    /**
+     * Show park assist
+     * @param region where it is placed
+     * @param units GMLAN_VAL_CLUSTER_UNITS_*
+     * @param distance PARK_ASSIST_DISTANCE in centimeters
+     * @param slots buf[2] and buf[3] of the frame, the middle, right and left nibbles
+     * @param state description of the state, for failures
+     */
+    static void expectParkAssist(
+        const Region& region,
+        uint8_t const units,
+        uint8_t const distance,
+        uint16_t const slots,
+        const char* state
+    ) {
+        GMParkAssist parkAssist(flusher, units);
+        uint8_t buf[8] = {
+            GMLAN_VAL_PARK_ASSIST_ON,
+            distance,
+            static_cast<uint8_t>(slots >> 8),
+            static_cast<uint8_t>(slots),
+            0, 0, 0, 0
+        };
+
+        parkAssist.place(region);
+        parkAssist.processMessage(GMLAN_MSG_PARK_ASSIST, sizeof(buf), buf);
+        parkAssist.render();
+        expectSameFrame(parkAssist, state);
+    }
+};
+
+PageFlusher* PageCanvasTest::flusher = nullptr;
+
+TEST_F(PageCanvasTest, TemperatureFullScreen) {
+    expectTemperature(FULL_SCREEN, GMLAN_VAL_CLUSTER_UNITS_METRIC, 0, "-40 C");
+    expectTemperature(FULL_SCREEN, GMLAN_VAL_CLUSTER_UNITS_METRIC, 81, "0.5 C");
+    expectTemperature(FULL_SCREEN, GMLAN_VAL_CLUSTER_UNITS_METRIC, 130, "25 C");
+    expectTemperature(FULL_SCREEN, GMLAN_VAL_CLUSTER_UNITS_IMPERIAL, 130, "77 F");
+    expectTemperature(FULL_SCREEN, GMLAN_VAL_CLUSTER_UNITS_IMPERIAL, 255, "189.5 F");
+}
+
+TEST_F(PageCanvasTest, TemperatureSideColumn) {
+    expectTemperature(SIDE_COLUMN, GMLAN_VAL_CLUSTER_UNITS_METRIC, 0, "compact -40 C");
+    expectTemperature(SIDE_COLUMN, GMLAN_VAL_CLUSTER_UNITS_METRIC, 130, "compact 25 C");
+    expectTemperature(SIDE_COLUMN, GMLAN_VAL_CLUSTER_UNITS_IMPERIAL, 255, "compact 189.5 F");
+}
+
+TEST_F(PageCanvasTest, TemperatureStale) {
+    for (const Region& region : {FULL_SCREEN, SIDE_COLUMN}) {
+        GMTemperature temperature(flusher, GMLAN_VAL_CLUSTER_UNITS_METRIC);
+
+        temperature.place(region);
+        temperature.restore(130, TEMPERATURE_STALE_AGE);
+        temperature.render();
+        expectSameFrame(temperature, region.w == SCREEN_WIDTH ? "stale 25 C" : "compact stale 25 C");
+    }
+}
+
+TEST_F(PageCanvasTest, ParkAssistFullScreen) {
+    expectParkAssist(FULL_SCREEN, GMLAN_VAL_CLUSTER_UNITS_METRIC, 0, 0x0001, "0 cm, stop left");
+    expectParkAssist(FULL_SCREEN, GMLAN_VAL_CLUSTER_UNITS_METRIC, 45, 0x2200, "45 cm, close middle right");
+    expectParkAssist(FULL_SCREEN, GMLAN_VAL_CLUSTER_UNITS_METRIC, 120, 0x3003, "120 cm, medium middle left");
+    expectParkAssist(FULL_SCREEN, GMLAN_VAL_CLUSTER_UNITS_IMPERIAL, 200, 0x0400, "79 in, far right");
+    expectParkAssist(FULL_SCREEN, GMLAN_VAL_CLUSTER_UNITS_IMPERIAL, 255, 0x0000, "100 in, nothing seen");
+}
+
+TEST_F(PageCanvasTest, ParkAssistBesideSideColumn) {
+    expectParkAssist(BESIDE_SIDE_COLUMN, GMLAN_VAL_CLUSTER_UNITS_METRIC, 45, 0x2000, "45 cm, close middle");
+    expectParkAssist(BESIDE_SIDE_COLUMN, GMLAN_VAL_CLUSTER_UNITS_IMPERIAL, 120, 0x0300, "47 in, medium right");
+}
+
+int main(int argc, char** argv) {
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}